@@ -0,0 +1,110 @@
+# Reports the size of every object file in the build and of the XBE, and what
+# changed since the previous report, so growth from a new feature or an Mbed TLS
+# config change shows up right away. With llvm-size the sizes are text + data +
+# bss of each object, otherwise the file sizes. The report is kept in
+# size_report.txt in the build directory.
+#
+# Included from CMakeLists.txt it defines add_size_report(), the target it
+# creates runs this file again in script mode to do the work.
+
+set(SIZE_REPORT_SCRIPT ${CMAKE_CURRENT_LIST_FILE})
+
+function(add_size_report TARGET_NAME XBE_FILE)
+    find_program(LLVM_SIZE_EXECUTABLE NAMES llvm-size)
+
+    add_custom_target(${TARGET_NAME}
+        COMMAND ${CMAKE_COMMAND}
+                -DBINARY_DIR=${CMAKE_BINARY_DIR}
+                -DXBE_FILE=${XBE_FILE}
+                -DSIZE_TOOL=${LLVM_SIZE_EXECUTABLE}
+                -P ${SIZE_REPORT_SCRIPT}
+        COMMENT "Size report"
+        VERBATIM
+    )
+endfunction()
+
+if(NOT CMAKE_SCRIPT_MODE_FILE)
+    return()
+endif()
+
+function(measure FILE_PATH RESULT)
+    set(size "")
+    if(SIZE_TOOL)
+        execute_process(COMMAND ${SIZE_TOOL} ${FILE_PATH} OUTPUT_VARIABLE output ERROR_QUIET)
+        # berkeley format, the line after the header reads "text data bss dec hex filename"
+        if(output MATCHES "\n[ \t]*[0-9]+[ \t]+[0-9]+[ \t]+[0-9]+[ \t]+([0-9]+)")
+            set(size ${CMAKE_MATCH_1})
+        endif()
+    endif()
+    if(size STREQUAL "")
+        file(SIZE ${FILE_PATH} size)
+    endif()
+    set(${RESULT} ${size} PARENT_SCOPE)
+endfunction()
+
+if(NOT BINARY_DIR)
+    message(FATAL_ERROR "SizeReport.cmake needs -DBINARY_DIR=<build directory>")
+endif()
+
+set(REPORT_FILE ${BINARY_DIR}/size_report.txt)
+
+# previous report, one "<size> <name>" line per file
+if(EXISTS ${REPORT_FILE})
+    file(STRINGS ${REPORT_FILE} previous_lines)
+    foreach(line ${previous_lines})
+        if(line MATCHES "^([0-9]+) (.+)$")
+            string(MAKE_C_IDENTIFIER "${CMAKE_MATCH_2}" key)
+            set(previous_${key} ${CMAKE_MATCH_1})
+        endif()
+    endforeach()
+endif()
+
+file(GLOB_RECURSE objects ${BINARY_DIR}/*.obj ${BINARY_DIR}/*.o)
+list(SORT objects)
+if(EXISTS ${XBE_FILE})
+    list(APPEND objects ${XBE_FILE})
+endif()
+
+set(report "")
+set(total 0)
+set(total_change 0)
+set(grown "")
+foreach(object ${objects})
+    measure(${object} size)
+    file(RELATIVE_PATH name ${BINARY_DIR} ${object})
+    string(APPEND report "${size} ${name}\n")
+
+    set(change "")
+    string(MAKE_C_IDENTIFIER "${name}" key)
+    if(DEFINED previous_${key})
+        math(EXPR delta "${size} - ${previous_${key}}")
+        if(delta GREATER 0)
+            set(change " (+${delta})")
+            list(APPEND grown "${name} +${delta}")
+        elseif(delta LESS 0)
+            set(change " (${delta})")
+        endif()
+        if(NOT object STREQUAL XBE_FILE)
+            math(EXPR total_change "${total_change} + ${delta}")
+        endif()
+    elseif(previous_lines)
+        set(change " (new)")
+        if(NOT object STREQUAL XBE_FILE)
+            math(EXPR total_change "${total_change} + ${size}")
+        endif()
+    endif()
+
+    if(object STREQUAL XBE_FILE)
+        message("XBE ${name}: ${size} bytes${change}")
+    else()
+        math(EXPR total "${total} + ${size}")
+        message("${size}${change} ${name}")
+    endif()
+endforeach()
+
+message("Objects: ${total} bytes (${total_change} since the last report)")
+foreach(entry ${grown})
+    message(WARNING "grew: ${entry} bytes")
+endforeach()
+
+file(WRITE ${REPORT_FILE} "${report}")
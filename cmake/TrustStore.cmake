@@ -0,0 +1,27 @@
+# Converts the downloaded PEM CA bundle into the indexed DER trust store that
+# src/network/TLSContext.cpp embeds. Without a Python interpreter the target
+# keeps embedding the PEM bundle and parses it at startup.
+function(add_trust_store TARGET_NAME PEM_FILE)
+    find_package(Python3 COMPONENTS Interpreter)
+    if(NOT Python3_Interpreter_FOUND)
+        message(WARNING "Python 3 not found, embedding PEM CA bundle instead of the DER trust store")
+        return()
+    endif()
+
+    set(TRUST_STORE_DIR ${CMAKE_CURRENT_BINARY_DIR}/assets)
+    set(TRUST_STORE_FILE ${TRUST_STORE_DIR}/truststore.bin)
+    file(MAKE_DIRECTORY ${TRUST_STORE_DIR})
+
+    add_custom_command(
+        OUTPUT ${TRUST_STORE_FILE}
+        COMMAND ${Python3_EXECUTABLE} ${CMAKE_SOURCE_DIR}/tools/make_truststore.py ${PEM_FILE} ${TRUST_STORE_FILE}
+        DEPENDS ${PEM_FILE} ${CMAKE_SOURCE_DIR}/tools/make_truststore.py
+        COMMENT "Generating DER trust store"
+        VERBATIM
+    )
+
+    target_sources(${TARGET_NAME} PRIVATE ${TRUST_STORE_FILE})
+    set_source_files_properties(${CMAKE_SOURCE_DIR}/src/network/TLSContext.cpp PROPERTIES OBJECT_DEPENDS ${TRUST_STORE_FILE})
+    target_include_directories(${TARGET_NAME} PRIVATE ${CMAKE_CURRENT_BINARY_DIR})
+    target_compile_definitions(${TARGET_NAME} PRIVATE UPDATER_DER_TRUST_STORE)
+endfunction()
@@ -1,4 +1,5 @@
 #define _CRT_RAND_S
+#include <errno.h>
 #include <stdlib.h>
 
 #include <lwip/netdb.h>
@@ -9,15 +10,41 @@
 #include <mbedtls/error.h>
 #include <mbedtls/net_sockets.h>
 #include <mbedtls/ssl.h>
+#include <mbedtls/threading.h>
 #include <mbedtls/x509_crt.h>
+#include <windows.h>
+
+#include "glue.h"
+
+static volatile LONG net_recv_calls = 0;
+static volatile LONG net_send_calls = 0;
 
 void mbedtls_net_init(mbedtls_net_context *ctx)
 {
     (void)ctx;
 }
 
-int mbedtls_net_connect(mbedtls_net_context *ctx, const char *host,
-                        const char *port, int proto)
+static int net_would_block(void)
+{
+    return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINPROGRESS;
+}
+
+static int net_wait_connected(int fd, uint32_t timeout)
+{
+    mbedtls_net_context ctx = { fd };
+    int error = 0;
+    socklen_t len = sizeof(error);
+
+    if (mbedtls_net_poll(&ctx, MBEDTLS_NET_POLL_WRITE, timeout) != MBEDTLS_NET_POLL_WRITE) {
+        return 0;
+    }
+
+    return getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &len) == 0 && error == 0;
+}
+
+int mbedtls_net_connect_timeout(mbedtls_net_context *ctx, const char *host,
+                                const char *port, int proto, uint32_t timeout,
+                                long long *resolved)
 {
     int ret = MBEDTLS_ERR_ERROR_CORRUPTION_DETECTED;
     struct addrinfo hints = {0};
@@ -31,6 +58,12 @@ int mbedtls_net_connect(mbedtls_net_context *ctx, const char *host,
         return MBEDTLS_ERR_NET_UNKNOWN_HOST;
     }
 
+    if (resolved != NULL) {
+        LARGE_INTEGER now;
+        QueryPerformanceCounter(&now);
+        *resolved = now.QuadPart;
+    }
+
     for (struct addrinfo *cur = addr_info; cur != NULL; cur = cur->ai_next) {
         ctx->fd = (int)socket(cur->ai_family, cur->ai_socktype,
                               cur->ai_protocol);
@@ -39,7 +72,16 @@ int mbedtls_net_connect(mbedtls_net_context *ctx, const char *host,
             continue;
         }
 
-        if (connect(ctx->fd, cur->ai_addr, cur->ai_addrlen) != 0) {
+        /* the socket stays non-blocking, every wait goes through select() with a timeout */
+        if (fcntl(ctx->fd, F_SETFL, O_NONBLOCK) != 0) {
+            ret = MBEDTLS_ERR_NET_SOCKET_FAILED;
+            close(ctx->fd);
+            ctx->fd = -1;
+            continue;
+        }
+
+        if (connect(ctx->fd, cur->ai_addr, cur->ai_addrlen) != 0 &&
+            (!net_would_block() || !net_wait_connected(ctx->fd, timeout))) {
             ret = MBEDTLS_ERR_NET_CONNECT_FAILED;
             close(ctx->fd);
             ctx->fd = -1;
@@ -55,16 +97,114 @@ int mbedtls_net_connect(mbedtls_net_context *ctx, const char *host,
     return (ret);
 }
 
+int mbedtls_net_connect(mbedtls_net_context *ctx, const char *host,
+                        const char *port, int proto)
+{
+    return mbedtls_net_connect_timeout(ctx, host, port, proto, NET_DEFAULT_CONNECT_TIMEOUT, NULL);
+}
+
+int mbedtls_net_poll(mbedtls_net_context *ctx, uint32_t rw, uint32_t timeout)
+{
+    int fd = ctx->fd;
+    int ret;
+    fd_set read_fds;
+    fd_set write_fds;
+    struct timeval tv;
+
+    if (fd < 0) {
+        return MBEDTLS_ERR_NET_INVALID_CONTEXT;
+    }
+
+    FD_ZERO(&read_fds);
+    FD_ZERO(&write_fds);
+    if (rw & MBEDTLS_NET_POLL_READ) {
+        FD_SET(fd, &read_fds);
+    }
+    if (rw & MBEDTLS_NET_POLL_WRITE) {
+        FD_SET(fd, &write_fds);
+    }
+
+    tv.tv_sec = timeout / 1000;
+    tv.tv_usec = (timeout % 1000) * 1000;
+
+    do {
+        ret = select(fd + 1, &read_fds, &write_fds, NULL,
+                     timeout == (uint32_t)-1 ? NULL : &tv);
+    } while (ret < 0 && errno == EINTR);
+
+    if (ret < 0) {
+        return MBEDTLS_ERR_NET_POLL_FAILED;
+    }
+
+    ret = 0;
+    if (FD_ISSET(fd, &read_fds)) {
+        ret |= MBEDTLS_NET_POLL_READ;
+    }
+    if (FD_ISSET(fd, &write_fds)) {
+        ret |= MBEDTLS_NET_POLL_WRITE;
+    }
+
+    return ret;
+}
+
 int mbedtls_net_send(void *ctx, const unsigned char *buf, size_t len)
 {
     int fd = ((mbedtls_net_context *)ctx)->fd;
-    return send(fd, buf, len, 0);
+    InterlockedIncrement(&net_send_calls);
+
+    int ret = send(fd, buf, len, 0);
+    if (ret < 0) {
+        if (net_would_block()) {
+            return MBEDTLS_ERR_SSL_WANT_WRITE;
+        }
+        if (errno == EPIPE || errno == ECONNRESET) {
+            return MBEDTLS_ERR_NET_CONN_RESET;
+        }
+        return MBEDTLS_ERR_NET_SEND_FAILED;
+    }
+
+    return ret;
 }
 
 int mbedtls_net_recv(void *ctx, unsigned char *buf, size_t len)
 {
     int fd = ((mbedtls_net_context *)ctx)->fd;
-    return recv(fd, buf, len, 0);
+    InterlockedIncrement(&net_recv_calls);
+
+    int ret = recv(fd, buf, len, 0);
+    if (ret < 0) {
+        if (net_would_block()) {
+            return MBEDTLS_ERR_SSL_WANT_READ;
+        }
+        if (errno == EPIPE || errno == ECONNRESET) {
+            return MBEDTLS_ERR_NET_CONN_RESET;
+        }
+        return MBEDTLS_ERR_NET_RECV_FAILED;
+    }
+
+    return ret;
+}
+
+int mbedtls_net_recv_timeout(void *ctx, unsigned char *buf, size_t len,
+                             uint32_t timeout)
+{
+    /* mbedtls passes 0 for no timeout, mbedtls_net_poll() wants (uint32_t)-1 */
+    int ret = mbedtls_net_poll((mbedtls_net_context *)ctx, MBEDTLS_NET_POLL_READ,
+                               timeout == 0 ? (uint32_t)-1 : timeout);
+    if (ret < 0) {
+        return ret;
+    }
+    if (ret == 0) {
+        return MBEDTLS_ERR_SSL_TIMEOUT;
+    }
+
+    return mbedtls_net_recv(ctx, buf, len);
+}
+
+void mbedtls_net_get_call_counts(unsigned long *recv_calls, unsigned long *send_calls)
+{
+    *recv_calls = (unsigned long)net_recv_calls;
+    *send_calls = (unsigned long)net_send_calls;
 }
 
 void mbedtls_net_free(mbedtls_net_context *ctx)
@@ -90,3 +230,51 @@ int mbedtls_hardware_poll(void *data, unsigned char *output, size_t len, size_t
     *olen = written;
     return 0;
 }
+
+#if defined(MBEDTLS_THREADING_ALT)
+static void win32_mutex_init(mbedtls_threading_mutex_t *mutex)
+{
+    InitializeCriticalSection(&mutex->cs);
+    mutex->is_valid = 1;
+}
+
+static void win32_mutex_free(mbedtls_threading_mutex_t *mutex)
+{
+    if (mutex->is_valid) {
+        DeleteCriticalSection(&mutex->cs);
+        mutex->is_valid = 0;
+    }
+}
+
+static int win32_mutex_lock(mbedtls_threading_mutex_t *mutex)
+{
+    if (!mutex->is_valid) {
+        return MBEDTLS_ERR_THREADING_BAD_INPUT_DATA;
+    }
+
+    EnterCriticalSection(&mutex->cs);
+    return 0;
+}
+
+static int win32_mutex_unlock(mbedtls_threading_mutex_t *mutex)
+{
+    if (!mutex->is_valid) {
+        return MBEDTLS_ERR_THREADING_BAD_INPUT_DATA;
+    }
+
+    LeaveCriticalSection(&mutex->cs);
+    return 0;
+}
+
+void mbedtls_threading_setup(void)
+{
+    static int initialized = 0;
+    if (initialized) {
+        return;
+    }
+
+    mbedtls_threading_set_alt(win32_mutex_init, win32_mutex_free,
+                              win32_mutex_lock, win32_mutex_unlock);
+    initialized = 1;
+}
+#endif
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <stdint.h>
+
+#include <mbedtls/net_sockets.h>
+
+/* used by mbedtls_net_connect(), which has no way to pass a timeout */
+#define NET_DEFAULT_CONNECT_TIMEOUT 10000
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Like mbedtls_net_connect(), but gives up when the TCP handshake takes longer
+ * than timeout milliseconds. The socket is left in non-blocking mode, so
+ * mbedtls_net_send/recv return MBEDTLS_ERR_SSL_WANT_WRITE/READ instead of
+ * blocking and mbedtls_net_poll() waits for it.
+ * If resolved is not NULL it receives the performance counter value at which
+ * the name lookup finished.
+ */
+int mbedtls_net_connect_timeout(mbedtls_net_context *ctx, const char *host,
+                                const char *port, int proto, uint32_t timeout,
+                                long long *resolved);
+
+/* Number of recv() and send() calls made by mbedtls_net_recv/send so far */
+void mbedtls_net_get_call_counts(unsigned long *recv_calls, unsigned long *send_calls);
+
+#ifdef __cplusplus
+}
+#endif
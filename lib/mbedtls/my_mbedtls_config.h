@@ -107,6 +107,11 @@
  * CPU supports SSE2 instruction set.
  *
  * Uncomment if the CPU supports SSE2 (IA-32 specific).
+ *
+ * Left off: the Xbox's Pentium III stops at SSE, this would fault on the first
+ * bignum multiply. MMX and SSE have no 32x32->64 bit multiply, so the i386
+ * MULADDC loop MBEDTLS_HAVE_ASM selects is as fast as it gets on this CPU.
+ * The public key benchmark (-DUPDATER_BENCHMARK=ON) times the result.
  */
 //#define MBEDTLS_HAVE_SSE2
 
@@ -2156,7 +2161,7 @@
  *
  * Uncomment this to allow your own alternate threading implementation.
  */
-//#define MBEDTLS_THREADING_ALT
+#define MBEDTLS_THREADING_ALT
 
 /**
  * \def MBEDTLS_THREADING_PTHREAD
@@ -2267,7 +2272,7 @@
  *
  * Uncomment to enable trusted certificate callbacks.
  */
-//#define MBEDTLS_X509_TRUSTED_CERTIFICATE_CALLBACK
+#define MBEDTLS_X509_TRUSTED_CERTIFICATE_CALLBACK
 
 /**
  * \def MBEDTLS_X509_REMOVE_INFO
@@ -2329,8 +2334,10 @@
  * Requires: MBEDTLS_HAVE_ASM (on some platforms, see note)
  *
  * This modules adds support for the AES-NI instructions on x86.
+ *
+ * The Xbox Pentium III has no AES-NI, all it would add is a CPUID check.
  */
-#define MBEDTLS_AESNI_C
+//#define MBEDTLS_AESNI_C
 
 /**
  * \def MBEDTLS_AESCE_C
@@ -3102,8 +3109,10 @@
  * Requires: MBEDTLS_HAVE_ASM
  *
  * This modules adds support for the VIA PadLock on x86.
+ *
+ * Only VIA CPUs have PadLock, on the Xbox it is a CPUID check per AES call.
  */
-#define MBEDTLS_PADLOCK_C
+//#define MBEDTLS_PADLOCK_C
 
 /**
  * \def MBEDTLS_PEM_PARSE_C
@@ -3749,7 +3758,7 @@
  *
  * Enable this layer to allow use of mutexes within Mbed TLS
  */
-//#define MBEDTLS_THREADING_C
+#define MBEDTLS_THREADING_C
 
 /**
  * \def MBEDTLS_TIMING_C
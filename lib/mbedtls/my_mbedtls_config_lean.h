@@ -0,0 +1,111 @@
+/**
+ * \file my_mbedtls_config_lean.h
+ *
+ * \brief Minimal TLS 1.2/1.3 client profile for the updater.
+ *
+ *  Starts from my_mbedtls_config.h and drops everything an HTTPS client
+ *  talking to GitHub never uses: DTLS, the server side, legacy ciphers,
+ *  static and PSK-only key exchanges, exotic curves, certificate writing
+ *  and the self tests. Selected with -DUPDATER_LEAN_TLS=ON.
+ *
+ *  What is left covers the ciphersuites, groups and signature algorithms
+ *  CTLSContext offers, plus parsing the CA bundle and session resumption.
+ *
+ *  check_config.h validates the result when Mbed TLS is built, the lean
+ *  profile is compiled by a step of its own in .github/workflows/build.yml.
+ */
+
+#include "my_mbedtls_config.h"
+
+/* DTLS */
+#undef MBEDTLS_SSL_PROTO_DTLS
+#undef MBEDTLS_SSL_DTLS_CONNECTION_ID
+#undef MBEDTLS_SSL_DTLS_CONNECTION_ID_COMPAT
+#undef MBEDTLS_SSL_DTLS_ANTI_REPLAY
+#undef MBEDTLS_SSL_DTLS_HELLO_VERIFY
+#undef MBEDTLS_SSL_DTLS_CLIENT_PORT_REUSE
+#undef MBEDTLS_SSL_COOKIE_C
+
+/* server side */
+#undef MBEDTLS_SSL_SRV_C
+#undef MBEDTLS_SSL_CACHE_C
+#undef MBEDTLS_SSL_TICKET_C
+
+/* TLS features the updater doesn't use */
+#undef MBEDTLS_SSL_CONTEXT_SERIALIZATION
+#undef MBEDTLS_SSL_KEYING_MATERIAL_EXPORT
+#undef MBEDTLS_SSL_RENEGOTIATION
+#undef MBEDTLS_SSL_ALL_ALERT_MESSAGES
+#undef MBEDTLS_SSL_ALPN
+#undef MBEDTLS_SSL_ENCRYPT_THEN_MAC
+
+/* only ECDHE suites are offered */
+#undef MBEDTLS_KEY_EXCHANGE_PSK_ENABLED
+#undef MBEDTLS_KEY_EXCHANGE_DHE_PSK_ENABLED
+#undef MBEDTLS_KEY_EXCHANGE_ECDHE_PSK_ENABLED
+#undef MBEDTLS_KEY_EXCHANGE_RSA_PSK_ENABLED
+#undef MBEDTLS_KEY_EXCHANGE_RSA_ENABLED
+#undef MBEDTLS_KEY_EXCHANGE_DHE_RSA_ENABLED
+#undef MBEDTLS_KEY_EXCHANGE_ECDH_ECDSA_ENABLED
+#undef MBEDTLS_KEY_EXCHANGE_ECDH_RSA_ENABLED
+#undef MBEDTLS_DHM_C
+#undef MBEDTLS_ECJPAKE_C
+
+/* AEAD only, ChaCha20-Poly1305 and AES-GCM */
+#undef MBEDTLS_CAMELLIA_C
+#undef MBEDTLS_ARIA_C
+#undef MBEDTLS_DES_C
+#undef MBEDTLS_CCM_C
+#undef MBEDTLS_CMAC_C
+#undef MBEDTLS_NIST_KW_C
+#undef MBEDTLS_CIPHER_MODE_CBC
+#undef MBEDTLS_CIPHER_MODE_CFB
+#undef MBEDTLS_CIPHER_MODE_OFB
+#undef MBEDTLS_CIPHER_MODE_XTS
+#undef MBEDTLS_CIPHER_PADDING_PKCS7
+#undef MBEDTLS_CIPHER_PADDING_ONE_AND_ZEROS
+#undef MBEDTLS_CIPHER_PADDING_ZEROS_AND_LEN
+#undef MBEDTLS_CIPHER_PADDING_ZEROS
+
+/* X25519, P-256 and P-384 cover the offered groups and the CA roots in use */
+#undef MBEDTLS_ECP_DP_SECP192R1_ENABLED
+#undef MBEDTLS_ECP_DP_SECP224R1_ENABLED
+#undef MBEDTLS_ECP_DP_SECP521R1_ENABLED
+#undef MBEDTLS_ECP_DP_SECP192K1_ENABLED
+#undef MBEDTLS_ECP_DP_SECP224K1_ENABLED
+#undef MBEDTLS_ECP_DP_SECP256K1_ENABLED
+#undef MBEDTLS_ECP_DP_BP256R1_ENABLED
+#undef MBEDTLS_ECP_DP_BP384R1_ENABLED
+#undef MBEDTLS_ECP_DP_BP512R1_ENABLED
+#undef MBEDTLS_ECP_DP_CURVE448_ENABLED
+#undef MBEDTLS_PK_PARSE_EC_EXTENDED
+#undef MBEDTLS_PK_PARSE_EC_COMPRESSED
+
+/* signatures are only verified, never made */
+#undef MBEDTLS_ECDSA_DETERMINISTIC
+#undef MBEDTLS_GENPRIME
+#undef MBEDTLS_PK_RSA_ALT_SUPPORT
+
+/* hashes no certificate or suite we accept uses */
+#undef MBEDTLS_MD5_C
+#undef MBEDTLS_RIPEMD160_C
+#undef MBEDTLS_SHA3_C
+
+/* key and certificate containers, writers and revocation lists */
+#undef MBEDTLS_LMS_C
+#undef MBEDTLS_PKCS5_C
+#undef MBEDTLS_PKCS7_C
+#undef MBEDTLS_PKCS12_C
+#undef MBEDTLS_PEM_WRITE_C
+#undef MBEDTLS_X509_CRL_PARSE_C
+#undef MBEDTLS_X509_CSR_PARSE_C
+#undef MBEDTLS_X509_CREATE_C
+#undef MBEDTLS_X509_CRT_WRITE_C
+#undef MBEDTLS_X509_CSR_WRITE_C
+
+/* diagnostics */
+#undef MBEDTLS_SELF_TEST
+#undef MBEDTLS_DEBUG_C
+#undef MBEDTLS_VERSION_C
+#undef MBEDTLS_VERSION_FEATURES
+#undef MBEDTLS_AESCE_C
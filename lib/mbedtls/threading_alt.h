@@ -0,0 +1,20 @@
+#pragma once
+
+#include <windows.h>
+
+/* Win32 critical sections back the mutexes of MBEDTLS_THREADING_ALT, see glue.c */
+typedef struct mbedtls_threading_mutex_t {
+    CRITICAL_SECTION cs;
+    char is_valid;
+} mbedtls_threading_mutex_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Has to run before anything else in mbedtls, including psa_crypto_init() */
+void mbedtls_threading_setup(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -20,6 +20,7 @@
  * IN THE SOFTWARE.
  */
 
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <stddef.h>
@@ -41,7 +42,7 @@ typedef struct {
 } mtar_raw_header_t;
 
 
-static unsigned round_up(unsigned n, unsigned incr) {
+static mtar_size_t round_up(mtar_size_t n, unsigned incr) {
   return n + (incr - n % incr) % incr;
 }
 
@@ -87,8 +88,91 @@ static int write_null_bytes(mtar_t *tar, int n) {
 }
 
 
+static int parse_number(const char *field, unsigned len, mtar_size_t *res) {
+  const unsigned char *p = (const unsigned char*) field;
+  const unsigned char *end = p + len;
+  mtar_size_t n = 0;
+
+  /* GNU base-256: the high bit of the first byte is set and the value follows
+   * big endian, the next bit is the sign */
+  if (*p & 0x80) {
+    if (*p & 0x40) {
+      return MTAR_EBADHEADER;
+    }
+    n = *p++ & 0x3f;
+    for (; p < end; p++) {
+      if (n >> 56) {
+        return MTAR_EBADHEADER;
+      }
+      n = (n << 8) | *p;
+    }
+    *res = n;
+    return MTAR_ESUCCESS;
+  }
+
+  /* Octal digits, optionally preceded by spaces and ended by a space or null
+   * byte. A 12 byte field holds at most 36 bits so this can't overflow */
+  while (p < end && *p == ' ') {
+    p++;
+  }
+  for (; p < end && *p >= '0' && *p <= '7'; p++) {
+    n = (n << 3) | (mtar_size_t) (*p - '0');
+  }
+  if (p < end && *p != ' ' && *p != '\0') {
+    return MTAR_EBADHEADER;
+  }
+  *res = n;
+  return MTAR_ESUCCESS;
+}
+
+
+static int parse_unsigned(const char *field, unsigned len, unsigned *res) {
+  mtar_size_t n;
+  int err = parse_number(field, len, &n);
+  if (err) {
+    return err;
+  }
+  if (n > UINT_MAX) {
+    return MTAR_EBADHEADER;
+  }
+  *res = (unsigned) n;
+  return MTAR_ESUCCESS;
+}
+
+
+static void write_number(char *field, unsigned len, mtar_size_t n) {
+  unsigned i;
+  /* Octal with a terminating null byte if it fits, base-256 otherwise */
+  if (n >> (3 * (len - 1)) == 0) {
+    field[len - 1] = '\0';
+    for (i = len - 1; i > 0; i--) {
+      field[i - 1] = (char) ('0' + (n & 7));
+      n >>= 3;
+    }
+    return;
+  }
+  for (i = len - 1; i > 0; i--) {
+    field[i] = (char) (n & 0xff);
+    n >>= 8;
+  }
+  field[0] = (char) 0x80;
+}
+
+
+static void copy_name(char *dst, const char *src, unsigned len) {
+  /* A name filling the whole field has no null byte */
+  unsigned n = 0;
+  while (n < len && src[n]) {
+    n++;
+  }
+  memcpy(dst, src, n);
+  dst[n] = '\0';
+}
+
+
 static int raw_to_header(mtar_header_t *h, const mtar_raw_header_t *rh) {
   unsigned chksum1, chksum2;
+  int err;
 
   /* If the checksum starts with a null byte we assume the record is NULL */
   if (*rh->checksum == '\0') {
@@ -97,19 +181,21 @@ static int raw_to_header(mtar_header_t *h, const mtar_raw_header_t *rh) {
 
   /* Build and compare checksum */
   chksum1 = checksum(rh);
-  sscanf(rh->checksum, "%o", &chksum2);
-  if (chksum1 != chksum2) {
+  err = parse_unsigned(rh->checksum, sizeof(rh->checksum), &chksum2);
+  if (err || chksum1 != chksum2) {
     return MTAR_EBADCHKSUM;
   }
 
   /* Load raw header into header */
-  sscanf(rh->mode, "%o", &h->mode);
-  sscanf(rh->owner, "%o", &h->owner);
-  sscanf(rh->size, "%o", &h->size);
-  sscanf(rh->mtime, "%o", &h->mtime);
+  if ( (err = parse_unsigned(rh->mode, sizeof(rh->mode), &h->mode)) ||
+       (err = parse_unsigned(rh->owner, sizeof(rh->owner), &h->owner)) ||
+       (err = parse_number(rh->size, sizeof(rh->size), &h->size)) ||
+       (err = parse_unsigned(rh->mtime, sizeof(rh->mtime), &h->mtime)) ) {
+    return err;
+  }
   h->type = rh->type;
-  strcpy(h->name, rh->name);
-  strcpy(h->linkname, rh->linkname);
+  copy_name(h->name, rh->name, sizeof(rh->name));
+  copy_name(h->linkname, rh->linkname, sizeof(rh->linkname));
 
   return MTAR_ESUCCESS;
 }
@@ -118,15 +204,20 @@ static int raw_to_header(mtar_header_t *h, const mtar_raw_header_t *rh) {
 static int header_to_raw(mtar_raw_header_t *rh, const mtar_header_t *h) {
   unsigned chksum;
 
+  /* Names have to fit the raw fields, which don't need a null byte */
+  if (strlen(h->name) > sizeof(rh->name) || strlen(h->linkname) > sizeof(rh->linkname)) {
+    return MTAR_EBADHEADER;
+  }
+
   /* Load header into raw header */
   memset(rh, 0, sizeof(*rh));
-  sprintf(rh->mode, "%o", h->mode);
-  sprintf(rh->owner, "%o", h->owner);
-  sprintf(rh->size, "%o", h->size);
-  sprintf(rh->mtime, "%o", h->mtime);
+  write_number(rh->mode, sizeof(rh->mode), h->mode);
+  write_number(rh->owner, sizeof(rh->owner), h->owner);
+  write_number(rh->size, sizeof(rh->size), h->size);
+  write_number(rh->mtime, sizeof(rh->mtime), h->mtime);
   rh->type = h->type ? h->type : MTAR_TREG;
-  strcpy(rh->name, h->name);
-  strcpy(rh->linkname, h->linkname);
+  memcpy(rh->name, h->name, strlen(h->name));
+  memcpy(rh->linkname, h->linkname, strlen(h->linkname));
 
   /* Calculate and write checksum */
   chksum = checksum(rh);
@@ -148,6 +239,7 @@ const char* mtar_strerror(int err) {
     case MTAR_EBADCHKSUM   : return "bad checksum";
     case MTAR_ENULLRECORD  : return "null record";
     case MTAR_ENOTFOUND    : return "file not found";
+    case MTAR_EBADHEADER   : return "bad header";
   }
   return "unknown error";
 }
@@ -163,9 +255,18 @@ static int file_read(mtar_t *tar, void *data, unsigned size) {
   return (res == size) ? MTAR_ESUCCESS : MTAR_EREADFAIL;
 }
 
-static int file_seek(mtar_t *tar, unsigned offset) {
-  int res = fseek(tar->stream, offset, SEEK_SET);
-  return (res == 0) ? MTAR_ESUCCESS : MTAR_ESEEKFAIL;
+static int file_seek(mtar_t *tar, mtar_size_t offset) {
+  /* fseek() takes a long, larger offsets are reached in steps */
+  int origin = SEEK_SET;
+  do {
+    long step = (offset > LONG_MAX) ? LONG_MAX : (long) offset;
+    if (fseek(tar->stream, step, origin) != 0) {
+      return MTAR_ESEEKFAIL;
+    }
+    offset -= (mtar_size_t) step;
+    origin = SEEK_CUR;
+  } while (offset > 0);
+  return MTAR_ESUCCESS;
 }
 
 static int file_close(mtar_t *tar) {
@@ -213,7 +314,7 @@ int mtar_close(mtar_t *tar) {
 }
 
 
-int mtar_seek(mtar_t *tar, unsigned pos) {
+int mtar_seek(mtar_t *tar, mtar_size_t pos) {
   int err = tar->seek(tar, pos);
   tar->pos = pos;
   return err;
@@ -228,7 +329,8 @@ int mtar_rewind(mtar_t *tar) {
 
 
 int mtar_next(mtar_t *tar) {
-  int err, n;
+  int err;
+  mtar_size_t n;
   mtar_header_t h;
   /* Load header */
   err = mtar_read_header(tar, &h);
@@ -305,6 +407,10 @@ int mtar_read_data(mtar_t *tar, void *ptr, unsigned size) {
     }
     tar->remaining_data = h.size;
   }
+  /* Don't read past the end of the entry's data */
+  if (size > tar->remaining_data) {
+    return MTAR_EREADFAIL;
+  }
   /* Read data */
   err = tread(tar, ptr, size);
   if (err) {
@@ -322,16 +428,23 @@ int mtar_read_data(mtar_t *tar, void *ptr, unsigned size) {
 
 int mtar_write_header(mtar_t *tar, const mtar_header_t *h) {
   mtar_raw_header_t rh;
+  int err;
   /* Build raw header and write */
-  header_to_raw(&rh, h);
+  err = header_to_raw(&rh, h);
+  if (err) {
+    return err;
+  }
   tar->remaining_data = h->size;
   return twrite(tar, &rh, sizeof(rh));
 }
 
 
-int mtar_write_file_header(mtar_t *tar, const char *name, unsigned size) {
+int mtar_write_file_header(mtar_t *tar, const char *name, mtar_size_t size) {
   mtar_header_t h;
   /* Build header */
+  if (strlen(name) >= sizeof(h.name)) {
+    return MTAR_EBADHEADER;
+  }
   memset(&h, 0, sizeof(h));
   strcpy(h.name, name);
   h.size = size;
@@ -345,6 +458,9 @@ int mtar_write_file_header(mtar_t *tar, const char *name, unsigned size) {
 int mtar_write_dir_header(mtar_t *tar, const char *name) {
   mtar_header_t h;
   /* Build header */
+  if (strlen(name) >= sizeof(h.name)) {
+    return MTAR_EBADHEADER;
+  }
   memset(&h, 0, sizeof(h));
   strcpy(h.name, name);
   h.type = MTAR_TDIR;
@@ -27,7 +27,8 @@ enum {
   MTAR_ESEEKFAIL    = -5,
   MTAR_EBADCHKSUM   = -6,
   MTAR_ENULLRECORD  = -7,
-  MTAR_ENOTFOUND    = -8
+  MTAR_ENOTFOUND    = -8,
+  MTAR_EBADHEADER   = -9
 };
 
 enum {
@@ -40,14 +41,18 @@ enum {
   MTAR_TFIFO  = '6'
 };
 
+/* Entry sizes and archive offsets, members can be 4 GB and larger */
+typedef unsigned long long mtar_size_t;
+
 typedef struct {
   unsigned mode;
   unsigned owner;
-  unsigned size;
+  mtar_size_t size;
   unsigned mtime;
   unsigned type;
-  char name[100];
-  char linkname[100];
+  /* The raw fields hold 100 characters without a terminating null byte */
+  char name[101];
+  char linkname[101];
 } mtar_header_t;
 
 
@@ -56,12 +61,12 @@ typedef struct mtar_t mtar_t;
 struct mtar_t {
   int (*read)(mtar_t *tar, void *data, unsigned size);
   int (*write)(mtar_t *tar, const void *data, unsigned size);
-  int (*seek)(mtar_t *tar, unsigned pos);
+  int (*seek)(mtar_t *tar, mtar_size_t pos);
   int (*close)(mtar_t *tar);
   void *stream;
-  unsigned pos;
-  unsigned remaining_data;
-  unsigned last_header;
+  mtar_size_t pos;
+  mtar_size_t remaining_data;
+  mtar_size_t last_header;
 };
 
 
@@ -70,7 +75,7 @@ const char* mtar_strerror(int err);
 int mtar_open(mtar_t *tar, const char *filename, const char *mode);
 int mtar_close(mtar_t *tar);
 
-int mtar_seek(mtar_t *tar, unsigned pos);
+int mtar_seek(mtar_t *tar, mtar_size_t pos);
 int mtar_rewind(mtar_t *tar);
 int mtar_next(mtar_t *tar);
 int mtar_find(mtar_t *tar, const char *name, mtar_header_t *h);
@@ -78,7 +83,7 @@ int mtar_read_header(mtar_t *tar, mtar_header_t *h);
 int mtar_read_data(mtar_t *tar, void *ptr, unsigned size);
 
 int mtar_write_header(mtar_t *tar, const mtar_header_t *h);
-int mtar_write_file_header(mtar_t *tar, const char *name, unsigned size);
+int mtar_write_file_header(mtar_t *tar, const char *name, mtar_size_t size);
 int mtar_write_dir_header(mtar_t *tar, const char *name);
 int mtar_write_data(mtar_t *tar, const void *data, unsigned size);
 int mtar_finalize(mtar_t *tar);
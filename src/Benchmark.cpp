@@ -0,0 +1,594 @@
+/*
+ *  Copyright (C) 2025-2025
+ *  This file is part of XBMC - https://github.com/antonic901/xbmc4xbox-redux
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#include "Benchmark.h"
+
+#include "Downloader.h"
+#include "Updater.h"
+#include "filesystem/HDDirectory.h"
+#include "filesystem/HDFile.h"
+#include "filesystem/TarExtractor.h"
+#include "network/TLSContext.h"
+#include "utils/JSONVariantParser.h"
+#include "utils/StringUtils.h"
+#include "utils/Stopwatch.h"
+#include "utils/Variant.h"
+
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#include <mbedtls/bignum.h>
+#include <mbedtls/cipher.h>
+#include <mbedtls/ctr_drbg.h>
+#include <mbedtls/ecp.h>
+#include <mbedtls/entropy.h>
+#include <mbedtls/ssl_ciphersuites.h>
+
+#include "mbedtls/glue.h"
+
+#include <microtar/microtar.h>
+
+static const int COMPRESSION_RUNS = 3;
+static const long long READ_SIZE_BENCHMARK_BYTES = 4 * 1024 * 1024;
+static const size_t CIPHER_BENCHMARK_BYTES = 4 * 1024 * 1024;
+// one full TLS record
+static const size_t CIPHER_RECORD_SIZE = 16 * 1024;
+static const size_t CIPHER_TAG_SIZE = 16;
+static const int MPI_MUL_RUNS = 200;
+static const int MPI_EXP_RUNS = 20;
+static const int ECP_RUNS = 5;
+// 2 MB of headers, about as many entries as a build has
+static const int TAR_BENCHMARK_ENTRIES = 4096;
+static const int TAR_RUNS = 5;
+// lots of tiny files, many small ones, some medium ones and a large image: 1 MB + 4 MB + 8 MB + 32 MB
+struct SyntheticEntries
+{
+  const char* type;
+  int count;
+  size_t size;
+};
+static const SyntheticEntries EXTRACT_ENTRIES[] = {
+  { "tiny", 1024, 1024 },
+  { "small", 256, 16 * 1024 },
+  { "medium", 16, 512 * 1024 },
+  { "large", 1, 32 * 1024 * 1024 },
+};
+
+// buffer size 0 keeps the configured one
+struct ExtractionRun
+{
+  size_t bufferSize;
+  bool bPreallocate;
+  unsigned int writers;
+};
+static const ExtractionRun EXTRACT_RUNS[] = {
+  { 64 * 1024, true, 3 },
+  { 256 * 1024, true, 3 },
+  { 1024 * 1024, true, 3 },
+  { 0, false, 3 },
+  { 0, true, 0 },
+  { 0, true, 1 },
+  { 0, true, 6 },
+};
+
+// RFC 7748 section 5.2, first X25519 test vector, little endian
+static const unsigned char X25519_SCALAR[32] = {
+  0xa5, 0x46, 0xe3, 0x6b, 0xf0, 0x52, 0x7c, 0x9d, 0x3b, 0x16, 0x15, 0x4b, 0x82, 0x46, 0x5e, 0xdd,
+  0x62, 0x14, 0x4c, 0x0a, 0xc1, 0xfc, 0x5a, 0x18, 0x50, 0x6a, 0x22, 0x44, 0xba, 0x44, 0x9a, 0xc4
+};
+static const unsigned char X25519_POINT[32] = {
+  0xe6, 0xdb, 0x68, 0x67, 0x58, 0x30, 0x30, 0xdb, 0x35, 0x94, 0xc1, 0xa4, 0x24, 0xb1, 0x5f, 0x7c,
+  0x72, 0x66, 0x24, 0xec, 0x26, 0xb3, 0x35, 0x3b, 0x10, 0xa9, 0x03, 0xa6, 0xd0, 0xab, 0x1c, 0x4c
+};
+static const unsigned char X25519_RESULT[32] = {
+  0xc3, 0xda, 0x55, 0x37, 0x9d, 0xe9, 0xc6, 0x90, 0x8e, 0x94, 0xea, 0x4d, 0xf2, 0x8d, 0x08, 0x4f,
+  0x32, 0xec, 0xcf, 0x03, 0x49, 0x1c, 0x71, 0xf7, 0x54, 0xb4, 0x07, 0x55, 0x77, 0xa2, 0x85, 0x52
+};
+
+void CBenchmark::Run(const std::string& strReleaseURL)
+{
+  printf("Running benchmarks\n");
+  MeasureTarHeaders();
+  MeasureExtraction();
+  MeasurePublicKeyMath();
+  CompareCiphers();
+  CompareCompression(strReleaseURL);
+
+  std::string strAssetURL = FindAsset(strReleaseURL, "XBMC4Xbox.tar");
+  if (!strAssetURL.empty())
+    CompareReadSizes(strAssetURL);
+}
+
+std::string CBenchmark::FindAsset(const std::string& strReleaseURL, const std::string& strAsset)
+{
+  std::string strBody;
+  CDownloader downloader;
+  CVariant data;
+  if (!downloader.Get(strReleaseURL, strBody) || !CJSONVariantParser::Parse(strBody, data) || !data["assets"].isArray())
+    return "";
+
+  for (auto it = data["assets"].begin_array(); it != data["assets"].end_array(); ++it)
+  {
+    if (it->isObject() && StringUtils::EqualsNoCase((*it)["name"].asString(), strAsset))
+      return (*it)["url"].asString();
+  }
+
+  return "";
+}
+
+void CBenchmark::CompareCompression(const std::string& strURL)
+{
+  CDownloader downloader;
+  for (int compressed = 1; compressed >= 0; --compressed)
+  {
+    float totalTime = 0.0f;
+    size_t size = 0;
+    for (int i = 0; i < COMPRESSION_RUNS; ++i)
+    {
+      std::string strBody;
+      CStopWatch watch;
+      watch.StartZero();
+      if (!downloader.Get(strURL, strBody, "application/vnd.github+json", compressed != 0))
+      {
+        printf("benchmark: request failed\n");
+        return;
+      }
+      totalTime += watch.GetElapsedMilliseconds();
+      size = strBody.size();
+    }
+
+    // bytes on the wire are printed by CDownloader::Get for every run
+    printf("benchmark: %s, %u bytes, %.2f ms average over %d runs\n", compressed ? "gzip" : "identity",
+           static_cast<unsigned int>(size), totalTime / COMPRESSION_RUNS, COMPRESSION_RUNS);
+  }
+}
+
+void CBenchmark::CompareReadSizes(const std::string& strAssetURL)
+{
+  static const size_t sizes[] = { 1024, 4096, 8192, 16384, 32768 };
+
+  const size_t previous = CDownloader::GetReadSize();
+  const std::string strRange = StringUtils::Format("Range: bytes=0-%lld\r\n", READ_SIZE_BENCHMARK_BYTES - 1);
+
+  // the first pass only resolves the redirect and warms up the connection pool
+  for (int i = -1; i < static_cast<int>(sizeof(sizes) / sizeof(sizes[0])); ++i)
+  {
+    CDownloader::SetReadSize(i < 0 ? previous : sizes[i]);
+    CDownloader downloader;
+
+    unsigned long recvBefore, sendBefore, recvAfter, sendAfter;
+    mbedtls_net_get_call_counts(&recvBefore, &sendBefore);
+
+    CStopWatch watch;
+    watch.StartZero();
+    unsigned long long received = 0;
+    CDownloader::Response response;
+    bool bResult = downloader.Request(strAssetURL, "application/octet-stream", strRange, response, [&received](const char*, size_t size) {
+      received += size;
+      return true;
+    });
+    const float seconds = watch.GetElapsedSeconds();
+    mbedtls_net_get_call_counts(&recvAfter, &sendAfter);
+
+    if (!bResult)
+    {
+      printf("benchmark: request failed\n");
+      break;
+    }
+
+    if (i < 0)
+      continue;
+
+    const float megabytes = received / (1024.0f * 1024.0f);
+    printf("benchmark: read size %5u, %.2f MB/s, %lu reads, %lu recv calls\n", static_cast<unsigned int>(sizes[i]),
+           seconds > 0.0f ? megabytes / seconds : 0.0f, downloader.GetReadCalls(), recvAfter - recvBefore);
+  }
+
+  CDownloader::SetReadSize(previous);
+}
+
+void CBenchmark::CompareCiphers()
+{
+  std::vector<mbedtls_cipher_type_t> measured;
+  for (const int* suite = CTLSContext::GetCiphersuites(); *suite != 0; ++suite)
+  {
+    const mbedtls_ssl_ciphersuite_t* info = mbedtls_ssl_ciphersuite_from_id(*suite);
+    if (!info)
+      continue;
+
+    // TLS 1.2 and 1.3 suites share their bulk ciphers, each is measured once
+    const mbedtls_cipher_type_t type = static_cast<mbedtls_cipher_type_t>(info->MBEDTLS_PRIVATE(cipher));
+    bool bMeasured = false;
+    for (mbedtls_cipher_type_t other : measured)
+      bMeasured = bMeasured || other == type;
+    if (bMeasured)
+      continue;
+    measured.push_back(type);
+
+    const mbedtls_cipher_info_t* cipherInfo = mbedtls_cipher_info_from_type(type);
+    if (!cipherInfo)
+      continue;
+
+    mbedtls_cipher_context_t cipher;
+    mbedtls_cipher_init(&cipher);
+
+    const unsigned char key[32] = { 0 };
+    const unsigned char iv[12] = { 0 };
+    const unsigned char ad[5] = { 0x17, 0x03, 0x03, 0x40, 0x11 };
+    std::vector<unsigned char> plain(CIPHER_RECORD_SIZE, 0xA5);
+    std::vector<unsigned char> record(CIPHER_RECORD_SIZE + CIPHER_TAG_SIZE);
+    std::vector<unsigned char> output(CIPHER_RECORD_SIZE + CIPHER_TAG_SIZE);
+    const int keyBits = static_cast<int>(mbedtls_cipher_info_get_key_bitlen(cipherInfo));
+    size_t length = 0;
+
+    bool bResult = mbedtls_cipher_setup(&cipher, cipherInfo) == 0 &&
+                   mbedtls_cipher_setkey(&cipher, key, keyBits, MBEDTLS_ENCRYPT) == 0 &&
+                   mbedtls_cipher_auth_encrypt_ext(&cipher, iv, sizeof(iv), ad, sizeof(ad), plain.data(), plain.size(),
+                                                   record.data(), record.size(), &length, CIPHER_TAG_SIZE) == 0 &&
+                   mbedtls_cipher_setkey(&cipher, key, keyBits, MBEDTLS_DECRYPT) == 0;
+
+    CStopWatch watch;
+    watch.StartZero();
+    for (size_t done = 0; bResult && done < CIPHER_BENCHMARK_BYTES; done += CIPHER_RECORD_SIZE)
+    {
+      size_t decrypted = 0;
+      bResult = mbedtls_cipher_auth_decrypt_ext(&cipher, iv, sizeof(iv), ad, sizeof(ad), record.data(), length,
+                                                output.data(), output.size(), &decrypted, CIPHER_TAG_SIZE) == 0;
+    }
+    const float seconds = watch.GetElapsedSeconds();
+    mbedtls_cipher_free(&cipher);
+
+    if (!bResult)
+    {
+      printf("benchmark: %s failed\n", mbedtls_ssl_get_ciphersuite_name(*suite));
+      continue;
+    }
+
+    const float megabytes = CIPHER_BENCHMARK_BYTES / (1024.0f * 1024.0f);
+    printf("benchmark: %s, %.2f MB/s decrypt\n", mbedtls_ssl_get_ciphersuite_name(*suite),
+           seconds > 0.0f ? megabytes / seconds : 0.0f);
+  }
+}
+
+void CBenchmark::MeasurePublicKeyMath()
+{
+  mbedtls_mpi a, x, expected, e;
+  mbedtls_mpi_init(&a);
+  mbedtls_mpi_init(&x);
+  mbedtls_mpi_init(&expected);
+  mbedtls_mpi_init(&e);
+
+  // (2^2048 - 1)^2 = 2^4096 - 2^2049 + 1, every limb product carries all the way through
+  const std::string strOnes(512, 'F');
+  const std::string strSquare = std::string(511, 'F') + "E" + std::string(511, '0') + "1";
+  bool bResult = mbedtls_mpi_read_string(&a, 16, strOnes.c_str()) == 0 &&
+                 mbedtls_mpi_read_string(&expected, 16, strSquare.c_str()) == 0 &&
+                 mbedtls_mpi_mul_mpi(&x, &a, &a) == 0 && mbedtls_mpi_cmp_mpi(&x, &expected) == 0;
+
+  CStopWatch watch;
+  watch.StartZero();
+  for (int i = 0; bResult && i < MPI_MUL_RUNS; ++i)
+    bResult = mbedtls_mpi_mul_mpi(&x, &a, &a) == 0;
+  const float mulTime = watch.GetElapsedMilliseconds() / MPI_MUL_RUNS;
+
+  if (bResult)
+    printf("benchmark: 2048 bit multiply, %.3f ms\n", mulTime);
+  else
+    printf("benchmark: 2048 bit multiply failed\n");
+
+  // the RSA public key operation: 2^65537 mod (2^2048 - 1) = 2^(65537 mod 2048) = 2
+  bResult = mbedtls_mpi_lset(&x, 2) == 0 && mbedtls_mpi_lset(&e, 65537) == 0 &&
+            mbedtls_mpi_exp_mod(&expected, &x, &e, &a, NULL) == 0 && mbedtls_mpi_cmp_int(&expected, 2) == 0;
+
+  watch.StartZero();
+  for (int i = 0; bResult && i < MPI_EXP_RUNS; ++i)
+    bResult = mbedtls_mpi_exp_mod(&expected, &x, &e, &a, NULL) == 0;
+  const float expTime = watch.GetElapsedMilliseconds() / MPI_EXP_RUNS;
+
+  if (bResult)
+    printf("benchmark: RSA-2048 public operation, %.3f ms\n", expTime);
+  else
+    printf("benchmark: RSA-2048 public operation failed\n");
+
+  mbedtls_mpi_free(&e);
+  mbedtls_mpi_free(&expected);
+  mbedtls_mpi_free(&x);
+  mbedtls_mpi_free(&a);
+
+  // point multiplication takes a RNG to blind the coordinates
+  mbedtls_entropy_context entropy;
+  mbedtls_ctr_drbg_context ctrDrbg;
+  mbedtls_entropy_init(&entropy);
+  mbedtls_ctr_drbg_init(&ctrDrbg);
+  if (mbedtls_ctr_drbg_seed(&ctrDrbg, mbedtls_entropy_func, &entropy, NULL, 0) == 0)
+  {
+    MeasureP256(&ctrDrbg);
+    MeasureX25519(&ctrDrbg);
+  }
+  mbedtls_ctr_drbg_free(&ctrDrbg);
+  mbedtls_entropy_free(&entropy);
+}
+
+void CBenchmark::MeasureP256(void* ctrDrbg)
+{
+  mbedtls_ecp_group grp;
+  mbedtls_ecp_point r, zero;
+  mbedtls_mpi k, one;
+  mbedtls_ecp_group_init(&grp);
+  mbedtls_ecp_point_init(&r);
+  mbedtls_ecp_point_init(&zero);
+  mbedtls_mpi_init(&k);
+  mbedtls_mpi_init(&one);
+
+  // [n - 1]G is -G, adding G to it has to give the point at infinity
+  bool bResult = mbedtls_ecp_group_load(&grp, MBEDTLS_ECP_DP_SECP256R1) == 0 &&
+                 mbedtls_mpi_sub_int(&k, &grp.N, 1) == 0 && mbedtls_mpi_lset(&one, 1) == 0 &&
+                 mbedtls_ecp_mul(&grp, &r, &k, &grp.G, mbedtls_ctr_drbg_random, ctrDrbg) == 0 &&
+                 mbedtls_ecp_muladd(&grp, &zero, &one, &r, &one, &grp.G) == 0 && mbedtls_ecp_is_zero(&zero) == 1;
+
+  // an ECDHE key share
+  CStopWatch watch;
+  watch.StartZero();
+  for (int i = 0; bResult && i < ECP_RUNS; ++i)
+    bResult = mbedtls_ecp_mul(&grp, &r, &k, &grp.G, mbedtls_ctr_drbg_random, ctrDrbg) == 0;
+  const float mulTime = watch.GetElapsedMilliseconds() / ECP_RUNS;
+
+  // the two multiplications of an ECDSA verification
+  watch.StartZero();
+  for (int i = 0; bResult && i < ECP_RUNS; ++i)
+    bResult = mbedtls_ecp_muladd(&grp, &zero, &k, &grp.G, &k, &r) == 0;
+  const float verifyTime = watch.GetElapsedMilliseconds() / ECP_RUNS;
+
+  if (bResult)
+    printf("benchmark: P-256 key share %.2f ms, ECDSA verify %.2f ms\n", mulTime, verifyTime);
+  else
+    printf("benchmark: P-256 failed\n");
+
+  mbedtls_mpi_free(&one);
+  mbedtls_mpi_free(&k);
+  mbedtls_ecp_point_free(&zero);
+  mbedtls_ecp_point_free(&r);
+  mbedtls_ecp_group_free(&grp);
+}
+
+void CBenchmark::MeasureX25519(void* ctrDrbg)
+{
+  mbedtls_ecp_keypair key;
+  mbedtls_ecp_point peer, shared;
+  mbedtls_ecp_keypair_init(&key);
+  mbedtls_ecp_point_init(&peer);
+  mbedtls_ecp_point_init(&shared);
+
+  unsigned char result[32];
+  size_t length = 0;
+  bool bResult = mbedtls_ecp_read_key(MBEDTLS_ECP_DP_CURVE25519, &key, X25519_SCALAR, sizeof(X25519_SCALAR)) == 0 &&
+                 mbedtls_ecp_point_read_binary(&key.MBEDTLS_PRIVATE(grp), &peer, X25519_POINT, sizeof(X25519_POINT)) == 0 &&
+                 mbedtls_ecp_mul(&key.MBEDTLS_PRIVATE(grp), &shared, &key.MBEDTLS_PRIVATE(d), &peer, mbedtls_ctr_drbg_random, ctrDrbg) == 0 &&
+                 mbedtls_ecp_point_write_binary(&key.MBEDTLS_PRIVATE(grp), &shared, MBEDTLS_ECP_PF_UNCOMPRESSED, &length, result, sizeof(result)) == 0 &&
+                 length == sizeof(X25519_RESULT) && memcmp(result, X25519_RESULT, sizeof(X25519_RESULT)) == 0;
+
+  CStopWatch watch;
+  watch.StartZero();
+  for (int i = 0; bResult && i < ECP_RUNS; ++i)
+    bResult = mbedtls_ecp_mul(&key.MBEDTLS_PRIVATE(grp), &shared, &key.MBEDTLS_PRIVATE(d), &peer, mbedtls_ctr_drbg_random, ctrDrbg) == 0;
+  const float mulTime = watch.GetElapsedMilliseconds() / ECP_RUNS;
+
+  if (bResult)
+    printf("benchmark: X25519 %.2f ms\n", mulTime);
+  else
+    printf("benchmark: X25519 failed\n");
+
+  mbedtls_ecp_point_free(&shared);
+  mbedtls_ecp_point_free(&peer);
+  mbedtls_ecp_keypair_free(&key);
+}
+
+// microtar callbacks for an archive held in a std::vector<char>
+static int MemoryRead(mtar_t* tar, void* data, unsigned size)
+{
+  const std::vector<char>* archive = static_cast<const std::vector<char>*>(tar->stream);
+  if (tar->pos + size > archive->size())
+    return MTAR_EREADFAIL;
+  memcpy(data, archive->data() + tar->pos, size);
+  return MTAR_ESUCCESS;
+}
+
+static int MemoryWrite(mtar_t* tar, const void* data, unsigned size)
+{
+  std::vector<char>* archive = static_cast<std::vector<char>*>(tar->stream);
+  const char* bytes = static_cast<const char*>(data);
+  archive->insert(archive->end(), bytes, bytes + size);
+  return MTAR_ESUCCESS;
+}
+
+static int MemorySeek(mtar_t* tar, mtar_size_t pos)
+{
+  const std::vector<char>* archive = static_cast<const std::vector<char>*>(tar->stream);
+  return pos <= archive->size() ? MTAR_ESUCCESS : MTAR_ESEEKFAIL;
+}
+
+static int MemoryClose(mtar_t* tar)
+{
+  (void)tar;
+  return MTAR_ESUCCESS;
+}
+
+void CBenchmark::MeasureTarHeaders()
+{
+  std::vector<char> archive;
+  mtar_t tar;
+  memset(&tar, 0, sizeof(tar));
+  tar.read = MemoryRead;
+  tar.write = MemoryWrite;
+  tar.seek = MemorySeek;
+  tar.close = MemoryClose;
+  tar.stream = &archive;
+
+  // a name filling the whole field has no null byte, 5 GB doesn't fit 11 octal digits
+  const std::string strLongName = "BUILD/" + std::string(94, 'n');
+  const mtar_size_t largeSize = 5ULL * 1024 * 1024 * 1024;
+  mtar_header_t header;
+  memset(&header, 0, sizeof(header));
+  strcpy(header.name, strLongName.c_str());
+  header.size = largeSize;
+  header.type = MTAR_TREG;
+  header.mode = 0664;
+  bool bResult = mtar_write_header(&tar, &header) == MTAR_ESUCCESS && mtar_rewind(&tar) == MTAR_ESUCCESS &&
+                 mtar_read_header(&tar, &header) == MTAR_ESUCCESS && header.size == largeSize &&
+                 strLongName == header.name;
+  if (!bResult)
+  {
+    printf("benchmark: tar headers failed\n");
+    return;
+  }
+
+  archive.clear();
+  tar.pos = 0;
+  for (int i = 0; bResult && i < TAR_BENCHMARK_ENTRIES; ++i)
+    bResult = mtar_write_file_header(&tar, StringUtils::Format("BUILD/system/file%d.xbe", i).c_str(), 0) == MTAR_ESUCCESS;
+  bResult = bResult && mtar_finalize(&tar) == MTAR_ESUCCESS;
+
+  int entries = 0;
+  CStopWatch watch;
+  watch.StartZero();
+  for (int run = 0; bResult && run < TAR_RUNS; ++run)
+  {
+    int ret;
+    mtar_rewind(&tar);
+    while ((ret = mtar_read_header(&tar, &header)) == MTAR_ESUCCESS)
+    {
+      ++entries;
+      mtar_next(&tar);
+    }
+    bResult = ret == MTAR_ENULLRECORD;
+  }
+  const float seconds = watch.GetElapsedSeconds();
+
+  if (!bResult || entries != TAR_BENCHMARK_ENTRIES * TAR_RUNS)
+  {
+    printf("benchmark: tar headers failed\n");
+    return;
+  }
+
+  printf("benchmark: tar headers, %.0f entries/s\n", seconds > 0.0f ? entries / seconds : 0.0f);
+}
+
+static bool WriteSyntheticEntries(mtar_t* tar, const std::vector<char>& data, const SyntheticEntries& entries)
+{
+  // the extractor only creates folders that have an entry of their own
+  const std::string strFolder = StringUtils::Format("BUILD/%s/", entries.type);
+  if (mtar_write_dir_header(tar, strFolder.c_str()) != MTAR_ESUCCESS)
+    return false;
+
+  for (int i = 0; i < entries.count; ++i)
+  {
+    const std::string strName = StringUtils::Format("BUILD/%s/file%d.bin", entries.type, i);
+    if (mtar_write_file_header(tar, strName.c_str(), entries.size) != MTAR_ESUCCESS)
+      return false;
+    for (size_t written = 0; written < entries.size; written += data.size())
+    {
+      const unsigned size = static_cast<unsigned>(std::min(data.size(), entries.size - written));
+      if (mtar_write_data(tar, data.data(), size) != MTAR_ESUCCESS)
+        return false;
+    }
+  }
+  return true;
+}
+
+// reads the extracted files back, a fragmented file takes longer to read
+static float ReadSyntheticEntries(const std::string& strDestination, std::vector<char>& buffer)
+{
+  CStopWatch watch;
+  watch.StartZero();
+  for (const SyntheticEntries& entries : EXTRACT_ENTRIES)
+  {
+    for (int i = 0; i < entries.count; ++i)
+    {
+      const std::string strFile = StringUtils::Format("%s%s\\file%d.bin", strDestination.c_str(), entries.type, i);
+      HANDLE hFile = CreateFileA(strFile.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                                 FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+      if (hFile == INVALID_HANDLE_VALUE)
+        return -1.0f;
+
+      DWORD dwRead = 0;
+      while (ReadFile(hFile, buffer.data(), buffer.size(), &dwRead, NULL) && dwRead > 0)
+        ;
+      CloseHandle(hFile);
+    }
+  }
+  return watch.GetElapsedSeconds();
+}
+
+void CBenchmark::MeasureExtraction()
+{
+  const std::string strArchive = CUpdater::GetCachePath() + "benchmark.tar";
+  const std::string strDestination = CUpdater::GetCachePath() + "benchmark\\";
+
+  std::vector<char> data(64 * 1024);
+  for (size_t i = 0; i < data.size(); ++i)
+    data[i] = static_cast<char>(i * 31);
+
+  float megabytes = 0.0f;
+  mtar_t tar;
+  bool bResult = mtar_open(&tar, strArchive.c_str(), "w") == MTAR_ESUCCESS;
+  if (bResult)
+  {
+    bResult = mtar_write_dir_header(&tar, "BUILD/") == MTAR_ESUCCESS;
+    for (const SyntheticEntries& entries : EXTRACT_ENTRIES)
+    {
+      bResult = bResult && WriteSyntheticEntries(&tar, data, entries);
+      megabytes += entries.count * entries.size / (1024.0f * 1024.0f);
+    }
+    bResult = bResult && mtar_finalize(&tar) == MTAR_ESUCCESS;
+    mtar_close(&tar);
+  }
+  if (!bResult)
+    printf("benchmark: writing %s failed\n", strArchive.c_str());
+
+  std::vector<char> buffer(CTarExtractor::MAX_BUFFER_SIZE);
+  const size_t configured = CTarExtractor::GetBufferSize();
+  const bool bConfiguredPreallocate = CTarExtractor::GetPreallocate();
+  const unsigned int configuredWriters = CTarExtractor::GetWriterCount();
+  for (const ExtractionRun& run : EXTRACT_RUNS)
+  {
+    if (!bResult)
+      break;
+
+    CTarExtractor::SetBufferSize(run.bufferSize > 0 ? run.bufferSize : configured);
+    CTarExtractor::SetPreallocate(run.bPreallocate);
+    CTarExtractor::SetWriterCount(run.writers);
+    CHDDirectory::WipeDir(strDestination);
+    CHDDirectory::Create(strDestination);
+
+    CTarExtractor extractor(strDestination);
+    CStopWatch watch;
+    watch.StartZero();
+    bResult = extractor.ExtractFile(strArchive);
+    const float seconds = watch.GetElapsedSeconds();
+    const float readSeconds = bResult ? ReadSyntheticEntries(strDestination, buffer) : -1.0f;
+
+    if (!bResult)
+      printf("benchmark: extract failed: %s\n", extractor.GetError().c_str());
+    else if (readSeconds < 0.0f)
+      printf("benchmark: reading the extracted files failed\n");
+    else
+      printf("benchmark: extract with %u KB buffer, %u writers%s, %.2f MB/s, read back %.2f MB/s\n",
+             static_cast<unsigned int>(CTarExtractor::GetBufferSize() / 1024), run.writers,
+             run.bPreallocate ? ", preallocated" : "", seconds > 0.0f ? megabytes / seconds : 0.0f,
+             readSeconds > 0.0f ? megabytes / readSeconds : 0.0f);
+  }
+  CTarExtractor::SetBufferSize(configured);
+  CTarExtractor::SetPreallocate(bConfiguredPreallocate);
+  CTarExtractor::SetWriterCount(configuredWriters);
+
+  CHDDirectory::WipeDir(strDestination);
+  CHDDirectory::Remove(strDestination);
+  CFileHD::Delete(strArchive);
+}
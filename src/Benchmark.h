@@ -0,0 +1,66 @@
+/*
+ *  Copyright (C) 2025-2025
+ *  This file is part of XBMC - https://github.com/antonic901/xbmc4xbox-redux
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+#include <string>
+
+/*!
+  \brief Measurements that help tune the updater on real hardware. Only built
+  with -DUPDATER_BENCHMARK=ON, results go to the debug output.
+*/
+class CBenchmark
+{
+public:
+  CBenchmark() = delete;
+
+  static void Run(const std::string& strReleaseURL);
+
+private:
+  /*!
+    \brief Fetches the release JSON with and without gzip and compares bytes received and time.
+  */
+  static void CompareCompression(const std::string& strURL);
+
+  /*!
+    \brief Downloads the same range of a release asset with different read sizes and
+    reports MB/s, reads from the TLS layer and recv() calls for each.
+  */
+  static void CompareReadSizes(const std::string& strAssetURL);
+
+  /*!
+    \brief Decrypts and authenticates TLS sized records with the cipher of every offered
+    ciphersuite and reports MB/s, which is the ceiling for the download speed.
+  */
+  static void CompareCiphers();
+
+  /*!
+    \brief Times the big number and curve arithmetic of a handshake: a 2048 bit multiply,
+    the RSA-2048 public key operation, P-256 key shares and ECDSA verification, and X25519.
+    Each is checked against a known answer first and reported as failed if it is wrong.
+  */
+  static void MeasurePublicKeyMath();
+  static void MeasureP256(void* ctrDrbg);
+  static void MeasureX25519(void* ctrDrbg);
+
+  /*!
+    \brief Times reading the headers of an in-memory archive with many entries. Long
+    names and a base-256 encoded size larger than 4 GB are checked first.
+  */
+  static void MeasureTarHeaders();
+
+  /*!
+    \brief Writes a build sized archive to the cache partition and extracts it with
+    different buffer sizes, with and without preallocating the files and with different
+    numbers of writer threads. Reports MB/s for extracting and for reading the files
+    back, which drops when they are fragmented.
+  */
+  static void MeasureExtraction();
+
+  static std::string FindAsset(const std::string& strReleaseURL, const std::string& strAsset);
+};
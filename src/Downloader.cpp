@@ -8,270 +8,719 @@
 
 #include "Downloader.h"
 
+#include "URL.h"
+#include "filesystem/AsyncFileWriter.h"
+#include "filesystem/HDFile.h"
+#include "network/ConnectionPool.h"
+#include "network/HTTPCache.h"
+#include "network/HTTPConnection.h"
+#include "network/RedirectCache.h"
+#include "network/RequestLog.h"
+#include "network/TLSContext.h"
+#include "utils/GZIPDecoder.h"
 #include "utils/StringUtils.h"
+#include "utils/Stopwatch.h"
 
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
 #include <windows.h>
 
-const unsigned char cert[] = {
-#embed "assets/cacert.pem" suffix(, ) // No suffix
-    0                                 // always null-terminated
+// one full TLS record, MBEDTLS_SSL_IN_CONTENT_LEN
+static const size_t DEFAULT_READ_SIZE = 16 * 1024;
+static const size_t MIN_READ_SIZE = 512;
+static const size_t MAX_READ_SIZE = 64 * 1024;
+
+// api.github.com -> CDN is a single hop, anything close to this is a loop
+static const int MAX_REDIRECTS = 5;
+
+// how many times an interrupted download is resumed before giving up
+static const int MAX_DOWNLOAD_ATTEMPTS = 5;
+
+// smaller pieces aren't worth another TLS handshake
+static const long long MIN_SEGMENT_SIZE = 2 * 1024 * 1024;
+// lwIP is built with MEMP_NUM_NETCONN=6, leave room for the pooled connections
+static const unsigned int MAX_SEGMENTS = 4;
+// a handshake needs a few KB of stack on top of the 16 KB record buffers on the heap
+static const SIZE_T SEGMENT_THREAD_STACK_SIZE = 64 * 1024;
+
+// how often a running download prints how far it got, in milliseconds
+static const DWORD PROGRESS_INTERVAL = 1000;
+
+struct CDownloader::Segment
+{
+  CDownloader* downloader = nullptr;
+  std::string strURL;
+  std::string strPath;
+  std::string strValidator;
+  long long start = 0;
+  long long end = 0;
+  long long received = 0;
+  bool bSuccess = false;
 };
 
-static void mbedtls_debug(void *ctx, int level, const char *file, int line, const char *str)
+// the sidecar next to a partial download remembers which version of the file it holds
+static bool ReadMeta(const std::string& strPath, std::string& strValidator, long long& total)
 {
-  (void)ctx;
-  (void)level;
-  printf("%s:%d: %s\n", file, line, str);
+  FILE* file = fopen(strPath.c_str(), "r");
+  if (!file)
+    return false;
+
+  char line[512];
+  bool bResult = false;
+  if (fgets(line, sizeof(line), file))
+  {
+    strValidator = line;
+    StringUtils::Trim(strValidator);
+    total = -1;
+    if (fgets(line, sizeof(line), file))
+      total = strtoll(line, NULL, 10);
+    bResult = !strValidator.empty();
+  }
+
+  fclose(file);
+  return bResult;
 }
 
-CDownloader::CDownloader()
+static bool WriteMeta(const std::string& strPath, const std::string& strValidator, long long total)
 {
-  Initialize();
+  FILE* file = fopen(strPath.c_str(), "w");
+  if (!file)
+    return false;
+
+  bool bResult = fprintf(file, "%s\n%lld\n", strValidator.c_str(), total) > 0;
+  return fclose(file) == 0 && bResult;
 }
 
-CDownloader::~CDownloader()
+size_t CDownloader::m_readSize = DEFAULT_READ_SIZE;
+
+CDownloader::CDownloader()
 {
-  Deinitialize();
+  Initialize();
 }
 
 void CDownloader::Initialize()
 {
-  mbedtls_debug_set_threshold(0);
-  mbedtls_entropy_init(&entropy);
-  mbedtls_ctr_drbg_init(&ctr_drbg);
-  mbedtls_x509_crt_init(&cacert);
-  mbedtls_ssl_init(&ssl);
-  mbedtls_ssl_config_init(&conf);
-  mbedtls_entropy_init(&entropy);
-  mbedtls_ssl_conf_authmode(&conf, MBEDTLS_SSL_VERIFY_REQUIRED);
-  mbedtls_ssl_conf_rng(&conf, mbedtls_ctr_drbg_random, &ctr_drbg);
-  mbedtls_ssl_conf_ca_chain(&conf, &cacert, NULL);
-  mbedtls_ssl_conf_dbg(&conf, mbedtls_debug, stdout);
-  mbedtls_net_init(&server_fd);
-  mbedtls_ssl_set_bio(&ssl, &server_fd, mbedtls_net_send, mbedtls_net_recv, NULL);
-
-  if (mbedtls_ctr_drbg_seed(&ctr_drbg, mbedtls_entropy_func, &entropy, NULL, 0) != 0)
-    return;
+  CStopWatch watch;
+  watch.StartZero();
 
-  if (mbedtls_x509_crt_parse(&cacert, (const unsigned char *)cert, sizeof(cert)) != 0)
+  m_context = CTLSContext::Get();
+  if (!m_context->IsValid())
     return;
 
-  if (mbedtls_ssl_config_defaults(&conf, MBEDTLS_SSL_IS_CLIENT, MBEDTLS_SSL_TRANSPORT_STREAM, MBEDTLS_SSL_PRESET_DEFAULT) != 0)
-    return;
+  printf("Downloader setup took %.2f ms\n", watch.GetElapsedMilliseconds());
+  m_initialized = true;
+}
 
-  if (mbedtls_ssl_setup(&ssl, &conf) != 0)
+void CDownloader::ReportProgress()
+{
+  const DWORD now = GetTickCount();
+  if (now - m_lastProgress < PROGRESS_INTERVAL)
     return;
 
-  m_initialized = true;
+  m_lastProgress = now;
+  const float megabytes = m_progress / (1024.0f * 1024.0f);
+  if (m_progressTotal > 0)
+    printf("Downloaded %.2f of %.2f MB\n", megabytes, m_progressTotal / (1024.0f * 1024.0f));
+  else
+    printf("Downloaded %.2f MB\n", megabytes);
 }
 
-void CDownloader::Deinitialize()
+void CDownloader::SetReadSize(size_t size)
 {
-  mbedtls_ssl_close_notify(&ssl);
-  mbedtls_ssl_free(&ssl);
-  mbedtls_ssl_config_free(&conf);
-  mbedtls_x509_crt_free(&cacert);
-  mbedtls_ctr_drbg_free(&ctr_drbg);
-  mbedtls_entropy_free(&entropy);
-  mbedtls_net_free(&server_fd);
-
-  m_initialized = false;
+  m_readSize = std::min(std::max(size, MIN_READ_SIZE), MAX_READ_SIZE);
 }
 
-bool CDownloader::Get(const std::string& strURL, std::string& strBody)
+bool CDownloader::Get(const std::string& strURL, std::string& strBody, const char* accept, bool bCompressed)
 {
-  mbedtls_ssl_session_reset(&ssl);
-
-  size_t iPos = strURL.find("://");
-  if (iPos == std::string::npos)
+  if (!m_initialized)
     return false;
 
-  std::string strHost = strURL.substr(iPos + 3);
-  iPos = strHost.find("/");
-  if (iPos == std::string::npos)
-    return false;
-  strHost = strHost.substr(0, iPos);
+  CStopWatch watch;
+  watch.StartZero();
+  m_bNotModified = false;
+
+  std::string strHeaders = bCompressed ? "Accept-Encoding: gzip\r\n" : "";
+
+  // let the server tell us the copy from the last run is still current
+  CHTTPCache::Entry cached;
+  const bool bCached = CHTTPCache::Get(strURL, cached);
+  if (bCached && !cached.etag.empty())
+    strHeaders += StringUtils::Format("If-None-Match: %s\r\n", cached.etag.c_str());
+  if (bCached && !cached.lastModified.empty())
+    strHeaders += StringUtils::Format("If-Modified-Since: %s\r\n", cached.lastModified.c_str());
+
+  CGZIPDecoder decoder;
+  unsigned long long received = 0;
+  Response response;
+  bool bResult = Request(strURL, accept, strHeaders, response, [&](const char* data, size_t size) {
+    received += size;
+    if (response.contentEncoding.empty() || StringUtils::EqualsNoCase(response.contentEncoding, "identity"))
+    {
+      strBody.append(data, size);
+      return true;
+    }
 
-  if (mbedtls_ssl_set_hostname(&ssl, strHost.c_str()) != 0)
-    return false;
+    if (!StringUtils::EqualsNoCase(response.contentEncoding, "gzip"))
+      return false;
+
+    return decoder.Decode(data, size, [&strBody](const char* output, size_t length) {
+      strBody.append(output, length);
+      return true;
+    });
+  });
+
+  // a gzip body cut short still inflates to something that looks plausible
+  if (bResult && StringUtils::EqualsNoCase(response.contentEncoding, "gzip") && !decoder.IsFinished())
+    bResult = false;
+
+  if (!bResult && bCached && response.status == 304)
+  {
+    printf("GET %s: not modified, %.2f ms\n", strURL.c_str(), watch.GetElapsedMilliseconds());
+    strBody = std::move(cached.body);
+    m_bNotModified = true;
+    return true;
+  }
 
-  if (mbedtls_net_connect(&server_fd, strHost.c_str(), "443", MBEDTLS_NET_PROTO_TCP) != 0)
+  if (bResult && (!response.etag.empty() || !response.lastModified.empty()))
+    CHTTPCache::Set(strURL, { response.etag, response.lastModified, "", strBody });
+
+  printf("GET %s: %llu bytes received, %u bytes decoded, %.2f ms\n", strURL.c_str(), received,
+         static_cast<unsigned int>(strBody.size()), watch.GetElapsedMilliseconds());
+  return bResult;
+}
+
+bool CDownloader::Download(const std::string& strDownloadLink, const std::string& strDownloadPath, unsigned int segments, const DataCallback& onData)
+{
+  if (!m_initialized)
     return false;
 
-  int ret;
-  while ((ret = mbedtls_ssl_handshake(&ssl)) != 0)
+  CStopWatch watch;
+  watch.StartZero();
+  m_received = 0;
+  m_diskStallTicks = 0;
+  m_streamed = 0;
+  m_strStreamValidator.clear();
+
+  // segments arrive out of order, a data callback needs a single stream
+  if (onData)
+    segments = 1;
+
+  // whatever the segmented download couldn't finish is picked up by the single stream below
+  bool bResult = segments > 1 && DownloadSegmented(strDownloadLink, strDownloadPath, std::min(segments, MAX_SEGMENTS));
+  for (int attempt = 0; !bResult && attempt < MAX_DOWNLOAD_ATTEMPTS; ++attempt)
   {
-    if (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE)
+    DownloadResult result = DownloadOnce(strDownloadLink, strDownloadPath, onData);
+    if (result != DownloadResult::RETRY)
     {
-      mbedtls_net_free(&server_fd);
-      return false;
+      bResult = result == DownloadResult::DONE;
+      break;
     }
+
+    printf("Download of %s interrupted, resuming\n", strDownloadLink.c_str());
   }
 
-  std::string strRequest = StringUtils::Format("GET %s HTTP/1.1\r\n"
-                                              "Host: %s\r\n"
-                                              "User-Agent: xbmc-updater\r\n"
-                                              "Accept: application/vnd.github+json\r\n"
-                                              "X-GitHub-Api-Version: 2022-11-28\r\n"
-                                              "Connection: close\r\n\r\n", strURL.c_str(), strHost.c_str());
-  if (mbedtls_ssl_write(&ssl, (const unsigned char *)strRequest.c_str(), strRequest.size()) <= 0)
+  if (bResult)
   {
-    mbedtls_net_free(&server_fd);
+    const float seconds = watch.GetElapsedSeconds();
+    const float megabytes = m_received / (1024.0f * 1024.0f);
+    const float stalled = static_cast<float>(m_diskStallTicks) / CStopWatch::GetFrequency();
+    printf("Downloaded %.2f MB in %.2f s (%.2f MB/s, %u segment(s), %.2f s waiting for the disk)\n", megabytes, seconds,
+           seconds > 0.0f ? megabytes / seconds : 0.0f, std::max(segments, 1u), stalled);
+  }
+
+  return bResult;
+}
+
+bool CDownloader::DownloadSegmented(const std::string& strDownloadLink, const std::string& strDownloadPath, unsigned int segments)
+{
+  // a one byte range tells us the size, the validator and where the redirects end up,
+  // without pulling the whole file if the server ignores ranges
+  Response probe;
+  Request(strDownloadLink, "application/octet-stream", "Range: bytes=0-0\r\n", probe, [&probe](const char*, size_t) {
+    return probe.status == 206;
+  });
+  if (probe.status != 206 || probe.rangeTotal <= 0 || probe.url.empty())
+    return false;
+
+  const long long total = probe.rangeTotal;
+  std::string strValidator = probe.etag;
+  if (strValidator.empty() || StringUtils::StartsWithNoCase(strValidator, "W/"))
+    strValidator = probe.lastModified;
+
+  // continue after the part an earlier attempt already got in order
+  const std::string strMetaPath = strDownloadPath + ".meta";
+  std::string strOldValidator;
+  long long oldTotal = -1;
+  long long offset = 0;
+  if (!strValidator.empty() && ReadMeta(strMetaPath, strOldValidator, oldTotal) && strOldValidator == strValidator && oldTotal == total)
+    offset = std::min(std::max(CFileHD::GetSize(strDownloadPath), 0LL), total);
+
+  if (offset == total)
+    return true;
+
+  const unsigned int count = static_cast<unsigned int>(std::min<long long>(segments, (total - offset) / MIN_SEGMENT_SIZE));
+  if (count < 2)
     return false;
+
+  // the preallocated file is full size long before it is complete, so it must not look resumable
+  CFileHD::Delete(strMetaPath);
+
+  HANDLE hFile = CreateFileA(strDownloadPath.c_str(), GENERIC_WRITE, 0, NULL, offset > 0 ? OPEN_ALWAYS : CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (hFile == INVALID_HANDLE_VALUE)
+    return false;
+
+  bool bAllocated = CFileHD::Preallocate(hFile, total);
+  CloseHandle(hFile);
+  if (!bAllocated)
+    return false;
+
+  printf("Downloading %lld bytes in %u segments\n", total - offset, count);
+  m_progress = offset;
+  m_progressTotal = total;
+
+  const long long length = (total - offset) / count;
+  std::vector<Segment> parts(count);
+  std::vector<HANDLE> threads(count, NULL);
+  for (unsigned int i = 0; i < count; ++i)
+  {
+    Segment& segment = parts[i];
+    segment.downloader = this;
+    segment.strURL = probe.url;
+    segment.strPath = strDownloadPath;
+    segment.strValidator = strValidator;
+    segment.start = offset + i * length;
+    segment.end = i + 1 == count ? total - 1 : segment.start + length - 1;
+    threads[i] = CreateThread(NULL, SEGMENT_THREAD_STACK_SIZE, SegmentThread, &segment, 0, NULL);
+  }
+
+  // the segments do the transfers, this thread only keeps the progress on screen
+  std::vector<HANDLE> running;
+  for (HANDLE thread : threads)
+  {
+    if (thread)
+      running.push_back(thread);
+  }
+  while (!running.empty() && WaitForMultipleObjects(running.size(), running.data(), TRUE, PROGRESS_INTERVAL) == WAIT_TIMEOUT)
+    ReportProgress();
+
+  bool bResult = true;
+  for (unsigned int i = 0; i < count; ++i)
+  {
+    if (threads[i])
+      CloseHandle(threads[i]);
+
+    m_received += parts[i].received;
+    bResult = bResult && threads[i] && parts[i].bSuccess;
+  }
+
+  // only the first segment grows the file from where it ended, cut the rest off so a
+  // single stream can resume from there
+  const long long complete = bResult ? total : offset + parts[0].received;
+  if (!bResult)
+  {
+    hFile = CreateFileA(strDownloadPath.c_str(), GENERIC_WRITE, 0, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (hFile != INVALID_HANDLE_VALUE)
+    {
+      LARGE_INTEGER size;
+      size.QuadPart = complete;
+      SetFilePointerEx(hFile, size, NULL, FILE_BEGIN);
+      SetEndOfFile(hFile);
+      CloseHandle(hFile);
+    }
   }
 
-  char buffer[4096];
-  ret = mbedtls_ssl_read(&ssl, (unsigned char *)buffer, sizeof(buffer));
-  if (ret <= 0)
+  if (!strValidator.empty() && complete > 0)
+    WriteMeta(strMetaPath, strValidator, total);
+
+  return bResult;
+}
+
+DWORD WINAPI CDownloader::SegmentThread(LPVOID param)
+{
+  Segment* segment = static_cast<Segment*>(param);
+  segment->bSuccess = segment->downloader->DownloadSegment(*segment);
+  return 0;
+}
+
+bool CDownloader::DownloadSegment(Segment& segment)
+{
+  HANDLE hFile = CreateFileA(segment.strPath.c_str(), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (hFile == INVALID_HANDLE_VALUE)
     return false;
 
-  std::string strHeader(buffer);
-  if (StringUtils::StartsWithNoCase(strHeader, "HTTP/1.1 4") || StringUtils::StartsWithNoCase(strHeader, "HTTP/1.1 5"))
+  LARGE_INTEGER position;
+  position.QuadPart = segment.start;
+  if (!SetFilePointerEx(hFile, position, NULL, FILE_BEGIN))
   {
-    mbedtls_ssl_close_notify(&ssl);
-    mbedtls_net_free(&server_fd);
+    CloseHandle(hFile);
     return false;
   }
 
-  if (StringUtils::StartsWithNoCase(strHeader, "HTTP/1.1 302"))
-  {
-    size_t iPos = strHeader.find("Location: ");
-    if (iPos == std::string::npos)
+  std::string strHeaders = StringUtils::Format("Range: bytes=%lld-%lld\r\n", segment.start, segment.end);
+  if (!segment.strValidator.empty())
+    strHeaders += StringUtils::Format("If-Range: %s\r\n", segment.strValidator.c_str());
+
+  const long long length = segment.end - segment.start + 1;
+  Response response;
+  CAsyncFileWriter writer(hFile);
+  bool bResult = Request(segment.strURL, "application/octet-stream", strHeaders, response, [&](const char* data, size_t size) {
+    // anything but exactly the requested range means the file changed underneath us
+    if (response.status != 206 || response.rangeStart != segment.start || segment.received + static_cast<long long>(size) > length)
       return false;
 
-    std::string strRedirectLink = strHeader.substr(iPos + 10);
-    iPos = strRedirectLink.find("\r\n");
-    if (iPos == std::string::npos)
+    if (!writer.Write(data, size))
       return false;
 
-    strRedirectLink = strRedirectLink.substr(0, iPos);
+    segment.received += size;
+    segment.downloader->m_progress += size;
+    return true;
+  });
 
-    mbedtls_ssl_close_notify(&ssl);
-    mbedtls_net_free(&server_fd);
-    return Get(strRedirectLink, strBody);
+  // nothing tells how much of the queued data made it to the disk, so none of it counts
+  if (!writer.Close())
+  {
+    bResult = false;
+    segment.received = 0;
+  }
+  segment.downloader->m_diskStallTicks += writer.GetStallTicks();
+
+  CloseHandle(hFile);
+  return bResult && segment.received == length;
+}
+
+CDownloader::DownloadResult CDownloader::DownloadOnce(const std::string& strDownloadLink, const std::string& strDownloadPath, const DataCallback& onData)
+{
+  const bool bCheckpoint = !strDownloadPath.empty();
+  const std::string strMetaPath = strDownloadPath + ".meta";
+
+  // a partial file is only continued when we know which version of the asset it belongs to,
+  // without a file only what reached the data callback earlier in this run is
+  std::string strValidator;
+  long long total = -1;
+  long long offset = 0;
+  if (!bCheckpoint)
+  {
+    strValidator = m_strStreamValidator;
+    offset = strValidator.empty() ? 0 : m_streamed;
+    total = m_progressTotal;
+  }
+  else if (ReadMeta(strMetaPath, strValidator, total))
+  {
+    offset = std::max(CFileHD::GetSize(strDownloadPath), 0LL);
   }
 
-  bool foundBody = false;
-  std::string strHeaderCache;
-  do
+  std::string strHeaders;
+  if (offset > 0)
   {
-    if (!foundBody)
+    printf("Resuming %s at %lld bytes\n", bCheckpoint ? strDownloadPath.c_str() : strDownloadLink.c_str(), offset);
+    strHeaders = StringUtils::Format("Range: bytes=%lld-\r\n"
+                                     "If-Range: %s\r\n", offset, strValidator.c_str());
+  }
+
+  Response response;
+  HANDLE hFile = INVALID_HANDLE_VALUE;
+  std::unique_ptr<CAsyncFileWriter> writer;
+  unsigned long long written = 0;
+  bool bStarted = false;
+  bool bRestart = false;
+  bool bResult = Request(strDownloadLink, "application/octet-stream", strHeaders, response, [&](const char* data, size_t size) {
+    // the file is only opened once the final response starts delivering its body
+    if (!bStarted)
     {
-      strHeaderCache.append(buffer, ret);
-      size_t iPos = strHeaderCache.find("\r\n\r\n");
-      if (iPos != std::string::npos)
+      if (response.status == 206)
       {
-        foundBody = true;
-        size_t iBodyPos = iPos + 4;
-        strBody.append(strHeaderCache.data() + iBodyPos, strHeaderCache.size() - iBodyPos);
+        // the server has to continue exactly where the partial file ends
+        if (offset == 0 || response.rangeStart != offset)
+        {
+          bRestart = true;
+          return false;
+        }
+
+        if (bCheckpoint)
+        {
+          // a data callback may read back the part an earlier run got
+          hFile = CreateFileA(strDownloadPath.c_str(), GENERIC_WRITE, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+          if (hFile != INVALID_HANDLE_VALUE && SetFilePointer(hFile, 0, NULL, FILE_END) == INVALID_SET_FILE_POINTER)
+          {
+            CloseHandle(hFile);
+            hFile = INVALID_HANDLE_VALUE;
+          }
+        }
+        total = response.rangeTotal;
       }
+      else
+      {
+        // the range was ignored or the asset changed since the partial download, start over
+        offset = 0;
+        if (bCheckpoint)
+          hFile = CreateFileA(strDownloadPath.c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+        total = response.contentLength;
+      }
+
+      if (bCheckpoint && hFile == INVALID_HANDLE_VALUE)
+        return false;
+
+      // If-Range needs a strong validator, weak ETags fall back to the modification date
+      std::string strNewValidator = response.etag;
+      if (strNewValidator.empty() || StringUtils::StartsWithNoCase(strNewValidator, "W/"))
+        strNewValidator = response.lastModified;
+
+      if (!bCheckpoint)
+        m_strStreamValidator = strNewValidator;
+      else if (strNewValidator.empty())
+        CFileHD::Delete(strMetaPath);
+      else if (strNewValidator != strValidator || offset == 0)
+        WriteMeta(strMetaPath, strNewValidator, total);
+
+      m_progress = offset;
+      m_progressTotal = total;
+      if (bCheckpoint)
+        writer.reset(new CAsyncFileWriter(hFile));
+      bStarted = true;
     }
-    else
-      strBody.append(buffer, ret);
-  } while ((ret = mbedtls_ssl_read(&ssl, (unsigned char *)buffer, sizeof(buffer))) > 0);
 
-  mbedtls_ssl_close_notify(&ssl);
-  mbedtls_net_free(&server_fd);
+    if (writer && !writer->Write(data, size))
+      return false;
+
+    if (onData && !onData(offset + written, data, size))
+      return false;
 
-  return true;
+    written += size;
+    m_streamed = offset + written;
+    m_progress += size;
+    ReportProgress();
+    return true;
+  });
+
+  if (hFile != INVALID_HANDLE_VALUE)
+  {
+    // a failed write leaves the file at its real size, which the next attempt resumes from
+    if (!writer->Close())
+      bResult = false;
+    m_diskStallTicks += writer->GetStallTicks();
+    CloseHandle(hFile);
+  }
+  m_received += written;
+
+  if (bResult && written != 0)
+    return DownloadResult::DONE;
+
+  if (bRestart)
+  {
+    DiscardPartial(strDownloadPath);
+    return DownloadResult::RETRY;
+  }
+
+  if (response.status == 416)
+  {
+    // nothing left to fetch, the partial file already holds the whole asset
+    if (offset > 0 && offset == total)
+      return DownloadResult::DONE;
+
+    // the partial file doesn't match the asset any more, drop it and download from scratch
+    DiscardPartial(strDownloadPath);
+    return offset > 0 ? DownloadResult::RETRY : DownloadResult::FAILED;
+  }
+
+  // keep going as long as every attempt gets further than the previous one
+  if (written != 0 && (bCheckpoint ? CFileHD::Exists(strMetaPath) : !m_strStreamValidator.empty()))
+    return DownloadResult::RETRY;
+
+  return DownloadResult::FAILED;
 }
 
-bool CDownloader::Download(const std::string& strDownloadLink, const std::string& strDownloadPath)
+void CDownloader::DiscardPartial(const std::string& strDownloadPath)
 {
-  mbedtls_ssl_session_reset(&ssl);
+  if (strDownloadPath.empty())
+  {
+    m_strStreamValidator.clear();
+    m_streamed = 0;
+    return;
+  }
 
-  size_t iPos = strDownloadLink.find("://");
-  if (iPos == std::string::npos)
-    return false;
+  CFileHD::Delete(strDownloadPath);
+  CFileHD::Delete(strDownloadPath + ".meta");
+}
 
-  std::string strHost = strDownloadLink.substr(iPos + 3);
-  iPos = strHost.find("/");
-  if (iPos == std::string::npos)
-    return false;
-  strHost = strHost.substr(0, iPos);
+static bool IsSuccess(int status)
+{
+  return status >= 200 && status < 300;
+}
 
-  if (mbedtls_ssl_set_hostname(&ssl, strHost.c_str()) != 0)
-    return false;
+static bool IsRedirect(int status)
+{
+  return status == 301 || status == 302 || status == 303 || status == 307 || status == 308;
+}
 
-  if (mbedtls_net_connect(&server_fd, strHost.c_str(), "443", MBEDTLS_NET_PROTO_TCP) != 0)
-    return false;
+bool CDownloader::Request(const std::string& strURL, const char* accept, const std::string& strHeaders, Response& response, const BodyCallback& onBody)
+{
+  // a redirect resolved a moment ago goes straight to its target
+  const std::string strTarget = CRedirectCache::Get(strURL);
+  if (!strTarget.empty())
+  {
+    if (FollowRedirects(strTarget, accept, strHeaders, response, onBody))
+      return true;
+
+    // part of a good response may already have reached the caller, that can't be repeated,
+    // and a 304 or 416 is a definite answer from the target
+    if (IsSuccess(response.status) || response.status == 304 || response.status == 416)
+      return false;
+
+    // the signed link most likely expired, ask the original URL again
+    CRedirectCache::Remove(strURL);
+  }
+
+  return FollowRedirects(strURL, accept, strHeaders, response, onBody);
+}
 
-  int ret;
-  while ((ret = mbedtls_ssl_handshake(&ssl)) != 0)
+bool CDownloader::FollowRedirects(const std::string& strURL, const char* accept, const std::string& strHeaders, Response& response, const BodyCallback& onBody)
+{
+  CURL url(strURL);
+  for (int redirects = 0;; ++redirects)
   {
-    if (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE)
+    if (!url.IsValid())
     {
-      mbedtls_net_free(&server_fd);
+      printf("Unsupported URL: %s\n", url.Get().c_str());
       return false;
     }
+
+    if (!Fetch(url, accept, strHeaders, response, onBody))
+      return false;
+
+    if (!IsRedirect(response.status))
+      break;
+
+    if (response.location.empty() || redirects == MAX_REDIRECTS)
+    {
+      printf("Giving up on redirect %i from %s\n", redirects + 1, url.Get().c_str());
+      return false;
+    }
+
+    // the connection went back to the pool, a redirect to the same host picks it up again
+    url = url.Resolve(response.location);
   }
 
-  std::string strRequest = StringUtils::Format("GET %s HTTP/1.1\r\n"
+  if (!IsSuccess(response.status))
+    return false;
+
+  if (response.url != strURL)
+    CRedirectCache::Set(strURL, response.url);
+
+  return true;
+}
+
+bool CDownloader::Fetch(const CURL& url, const char* accept, const std::string& strHeaders, Response& response, const BodyCallback& onBody)
+{
+  const std::string& strHost = url.GetHostName();
+  std::string strRequest = StringUtils::Format("GET /%s HTTP/1.1\r\n"
                                               "Host: %s\r\n"
                                               "User-Agent: xbmc-updater\r\n"
-                                              "Accept: application/octet-stream\r\n"
+                                              "Accept: %s\r\n"
                                               "X-GitHub-Api-Version: 2022-11-28\r\n"
-                                              "Connection: close\r\n\r\n", strDownloadLink.c_str(), strHost.c_str());
-  if (mbedtls_ssl_write(&ssl, (const unsigned char *)strRequest.c_str(), strRequest.size()) <= 0)
+                                              "%s\r\n", url.GetFileName().c_str(), strHost.c_str(), accept, strHeaders.c_str());
+
+  const bool bTimed = CRequestLog::IsEnabled();
+  for (int attempt = 0; attempt < 2; ++attempt)
   {
-    mbedtls_net_free(&server_fd);
-    return false;
-  }
+    const long long start = bTimed ? CStopWatch::GetTicks() : 0;
+    std::unique_ptr<CHTTPConnection> connection = CConnectionPool::Acquire(strHost, attempt > 0);
+    if (!connection)
+      return false;
 
-  char buffer[4096];
-  ret = mbedtls_ssl_read(&ssl, (unsigned char *)buffer, sizeof(buffer));
-  if (ret <= 0)
-    return false;
+    const bool bReused = connection->GetRequestCount() > 0;
+    const unsigned long long written = connection->GetBytesWritten();
+    const unsigned long long read = connection->GetBytesRead();
+    response = Response();
+    response.url = url.Get();
+    ResponseResult result = ResponseResult::NO_RESPONSE;
+    const long long requested = bTimed ? CStopWatch::GetTicks() : 0;
+    if (connection->Write(strRequest.c_str(), strRequest.size()))
+      result = ReadResponse(*connection, response, onBody);
 
-  std::string strHeader(buffer);
-  if (StringUtils::StartsWithNoCase(strHeader, "HTTP/1.1 4") || StringUtils::StartsWithNoCase(strHeader, "HTTP/1.1 5"))
-    return false;
+    if (bTimed)
+      LogRequest(*connection, response, bReused, start, requested, written, read);
 
-  if (StringUtils::StartsWithNoCase(strHeader, "HTTP/1.1 302"))
-  {
-    size_t iPos = strHeader.find("Location: ");
-    if (iPos == std::string::npos)
-      return false;
+    // the server may have closed a pooled connection while it sat idle, try once more on a fresh one
+    if (result == ResponseResult::NO_RESPONSE && bReused)
+      continue;
 
-    std::string strRedirectLink = strHeader.substr(iPos + 10);
-    iPos = strRedirectLink.find("\r\n");
-    if (iPos == std::string::npos)
+    if (result != ResponseResult::OK)
       return false;
 
-    strRedirectLink = strRedirectLink.substr(0, iPos);
+    if (response.keepAlive)
+      CConnectionPool::Release(std::move(connection));
 
-    mbedtls_ssl_close_notify(&ssl);
-    mbedtls_net_free(&server_fd);
-    return Download(strRedirectLink, strDownloadPath);
+    return true;
   }
 
-  DWORD written = 0;
-  HANDLE hFile = CreateFileA(strDownloadPath.c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
-  if (hFile != INVALID_HANDLE_VALUE)
+  return false;
+}
+
+void CDownloader::LogRequest(const CHTTPConnection& connection, const Response& response, bool bReused,
+                             long long start, long long requested, unsigned long long written, unsigned long long read)
+{
+  const long long now = CStopWatch::GetTicks();
+  const float frequency = CStopWatch::GetFrequency() / 1000.0f;
+
+  RequestTimings timings;
+  timings.url = response.url;
+  timings.status = response.status;
+  timings.reused = bReused;
+  if (!bReused)
   {
-    bool foundBody = false;
-    std::string strHeaderCache;
-    do
-    {
-      if (!foundBody)
-      {
-        strHeaderCache.append(buffer, ret);
-        size_t iPos = strHeaderCache.find("\r\n\r\n");
-        if (iPos != std::string::npos)
-        {
-          foundBody = true;
-          size_t iBodyPos = iPos + 4;
-          WriteFile(hFile, strHeaderCache.data() + iBodyPos, strHeaderCache.size() - iBodyPos, &written, NULL);
-        }
-      }
-      else
-        WriteFile(hFile, buffer, ret, &written, NULL);
-    } while ((ret = mbedtls_ssl_read(&ssl, (unsigned char *)buffer, sizeof(buffer))) > 0);
-    CloseHandle(hFile);
+    const CHTTPConnection::ConnectTimes& times = connection.GetConnectTimes();
+    timings.dns = (times.resolved - times.start) / frequency;
+    timings.connect = (times.connected - times.resolved) / frequency;
+    timings.handshake = (times.handshakeDone - times.connected) / frequency;
+    timings.keyExchange = times.keyExchange / frequency;
+    timings.authentication = times.authentication / frequency;
+    timings.finished = times.finished / frequency;
   }
+  // from sending the request to the start of the answer
+  if (connection.GetFirstByteTime() > requested)
+    timings.firstByte = (connection.GetFirstByteTime() - requested) / frequency;
+  timings.total = (now - start) / frequency;
+  timings.sent = connection.GetBytesWritten() - written;
+  timings.received = connection.GetBytesRead() - read;
+  CRequestLog::Add(timings);
+}
 
-  mbedtls_ssl_close_notify(&ssl);
-  mbedtls_net_free(&server_fd);
+CDownloader::ResponseResult CDownloader::ReadResponse(CHTTPConnection& connection, Response& response, const BodyCallback& onBody)
+{
+  // only a successful response carries the body the caller asked for, anything
+  // else is still read to the end so the connection can be reused
+  CHTTPResponseParser parser(response, [&response, &onBody](const char* data, size_t size) {
+    return response.status < 200 || response.status >= 300 || size == 0 || onBody(data, size);
+  });
+
+  // on the heap, segment threads run with small stacks
+  std::vector<char> buffer(m_readSize);
+  while (!parser.IsDone())
+  {
+    // don't pull bytes past the end of a sized body out of the TLS layer
+    size_t size = buffer.size();
+    const long long remaining = parser.GetRemaining();
+    if (remaining > 0)
+      size = static_cast<size_t>(std::min<long long>(remaining, size));
+
+    m_readCalls++;
+    int ret = connection.Read(buffer.data(), size);
+    // only an orderly close can end a body that runs until the connection closes,
+    // a timeout, reset or TLS error leaves it truncated
+    if (ret == 0 && parser.Finish())
+      break;
+    if (ret <= 0)
+      return parser.HasData() ? ResponseResult::FAILED : ResponseResult::NO_RESPONSE;
+
+    const size_t consumed = parser.Parse(buffer.data(), ret);
+    if (parser.IsFailed())
+      return ResponseResult::FAILED;
+
+    // anything past the end of the response would be lost, so don't put the connection back
+    if (consumed < static_cast<size_t>(ret))
+      response.keepAlive = false;
+  }
 
-  return written != 0;
+  return ResponseResult::OK;
 }
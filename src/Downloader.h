@@ -6,36 +6,126 @@
  *  See LICENSE.md for more information.
  */
 
+#pragma once
+
+#include "network/HTTPResponseParser.h"
+
+#include <atomic>
+#include <functional>
+#include <memory>
 #include <string>
+#include <windows.h>
 
-#include <mbedtls/ctr_drbg.h>
-#include <mbedtls/debug.h>
-#include <mbedtls/entropy.h>
-#include <mbedtls/error.h>
-#include <mbedtls/net_sockets.h>
-#include <mbedtls/ssl.h>
-#include <mbedtls/x509_crt.h>
+class CHTTPConnection;
+class CTLSContext;
+class CURL;
 
 class CDownloader
 {
 public:
   CDownloader();
-  ~CDownloader();
+  ~CDownloader() = default;
+
+  /*!
+    \brief Fetches a small document into memory. Responses with a validator are kept
+    in CHTTPCache and revalidated with a conditional request the next time.
+    \param bCompressed ask for a gzip encoded response and inflate it while it arrives
+  */
+  bool Get(const std::string& strURL, std::string& strBody, const char* accept = "application/vnd.github+json", bool bCompressed = true);
+
+  /*!
+    \brief Whether the last Get() was answered with the cached body after a 304 Not Modified.
+  */
+  bool IsNotModified() const { return m_bNotModified; }
 
-  bool Get(const std::string& strURL, std::string& strBody);
+  /*!
+    \brief Receives the body of a download in order, along with where in the file the data goes.
+    Returning false aborts the attempt.
+  */
+  typedef std::function<bool(long long offset, const char* data, size_t size)> DataCallback;
 
-  bool Download(const std::string& strDownloadLink, const std::string& strDownloadPath);
+  /*!
+    \brief Downloads a file, continuing a partial download left by an earlier attempt.
+    \param strDownloadPath where the file goes, empty to only hand the data to onData. Without
+    a file an interrupted transfer is still resumed within the call, but not by a later run.
+    \param segments number of concurrent ranged requests used for large files, 1 downloads over a single stream
+    \param onData sees every byte as it arrives, forces a single stream. After a resume the
+    offset can jump ahead of or back behind what it saw before.
+  */
+  bool Download(const std::string& strDownloadLink, const std::string& strDownloadPath, unsigned int segments = 1,
+                const DataCallback& onData = nullptr);
+
+  /*!
+    \brief Largest amount of data asked from the TLS layer in one read. A read never
+    returns more than one record, so there is no gain beyond the 16 KB record size.
+  */
+  static void SetReadSize(size_t size);
+  static size_t GetReadSize() { return m_readSize; }
+
+  /*!
+    \brief Number of reads from the TLS layer made by this downloader.
+  */
+  unsigned long GetReadCalls() const { return m_readCalls; }
 
 private:
+  friend class CBenchmark;
+
+  typedef std::function<bool(const char* data, size_t size)> BodyCallback;
+
+  typedef HTTPResponse Response;
+
+  enum class DownloadResult
+  {
+    DONE,
+    RETRY,
+    FAILED
+  };
+
+  enum class ResponseResult
+  {
+    OK,
+    FAILED,
+    NO_RESPONSE
+  };
+
   void Initialize();
-  void Deinitialize();
 
-  mbedtls_net_context server_fd;
-  mbedtls_entropy_context entropy;
-  mbedtls_ctr_drbg_context ctr_drbg;
-  mbedtls_ssl_context ssl;
-  mbedtls_ssl_config conf;
-  mbedtls_x509_crt cacert;
+  /*!
+    \brief Prints how far the current download got, at most once per interval.
+  */
+  void ReportProgress();
+
+  struct Segment;
 
+  DownloadResult DownloadOnce(const std::string& strDownloadLink, const std::string& strDownloadPath, const DataCallback& onData);
+  void DiscardPartial(const std::string& strDownloadPath);
+  bool DownloadSegmented(const std::string& strDownloadLink, const std::string& strDownloadPath, unsigned int segments);
+  bool DownloadSegment(Segment& segment);
+  static DWORD WINAPI SegmentThread(LPVOID param);
+
+  /*!
+    \brief Sends a GET and follows redirects, true if it ends in a 2xx response.
+  */
+  bool Request(const std::string& strURL, const char* accept, const std::string& strHeaders, Response& response, const BodyCallback& onBody);
+  bool FollowRedirects(const std::string& strURL, const char* accept, const std::string& strHeaders, Response& response, const BodyCallback& onBody);
+  bool Fetch(const CURL& url, const char* accept, const std::string& strHeaders, Response& response, const BodyCallback& onBody);
+  ResponseResult ReadResponse(CHTTPConnection& connection, Response& response, const BodyCallback& onBody);
+  void LogRequest(const CHTTPConnection& connection, const Response& response, bool bReused,
+                  long long start, long long requested, unsigned long long written, unsigned long long read);
+
+  std::shared_ptr<CTLSContext> m_context;
+
+  unsigned long long m_received = 0;
+  // how far a download without a file got and which version of the file it was
+  long long m_streamed = 0;
+  std::string m_strStreamValidator;
+  std::atomic<long long> m_progress{0};
+  std::atomic<long long> m_diskStallTicks{0};
+  long long m_progressTotal = -1;
+  DWORD m_lastProgress = 0;
+  std::atomic<unsigned long> m_readCalls{0};
   bool m_initialized = false;
+  bool m_bNotModified = false;
+
+  static size_t m_readSize;
 };
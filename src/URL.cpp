@@ -0,0 +1,101 @@
+/*
+ *  Copyright (C) 2025-2025
+ *  This file is part of XBMC - https://github.com/antonic901/xbmc4xbox-redux
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#include "URL.h"
+
+#include "utils/StringUtils.h"
+
+#include <stdlib.h>
+
+CURL::CURL(const std::string& strURL)
+{
+  Parse(strURL);
+}
+
+void CURL::Parse(const std::string& strURL)
+{
+  m_strProtocol.clear();
+  m_strHostName.clear();
+  m_strFileName.clear();
+  m_iPort = 0;
+
+  size_t iPos = strURL.find("://");
+  if (iPos == std::string::npos)
+    return;
+
+  m_strProtocol = strURL.substr(0, iPos);
+  StringUtils::ToLower(m_strProtocol);
+  iPos += 3;
+
+  // the fragment never goes to the server
+  size_t iEnd = strURL.find('#', iPos);
+  if (iEnd == std::string::npos)
+    iEnd = strURL.size();
+
+  size_t iSlash = strURL.find_first_of("/?", iPos);
+  if (iSlash == std::string::npos || iSlash > iEnd)
+    iSlash = iEnd;
+
+  m_strHostName = strURL.substr(iPos, iSlash - iPos);
+  size_t iColon = m_strHostName.find(':');
+  if (iColon != std::string::npos)
+  {
+    m_iPort = atoi(m_strHostName.c_str() + iColon + 1);
+    m_strHostName.erase(iColon);
+  }
+
+  if (iSlash < iEnd && strURL[iSlash] == '/')
+    iSlash++;
+  m_strFileName = strURL.substr(iSlash, iEnd - iSlash);
+}
+
+bool CURL::IsValid() const
+{
+  return m_strProtocol == "https" && !m_strHostName.empty() && (m_iPort == 0 || m_iPort == 443);
+}
+
+std::string CURL::Get() const
+{
+  if (m_strProtocol.empty())
+    return "";
+
+  std::string strURL = m_strProtocol + "://" + m_strHostName;
+  if (m_iPort != 0)
+    strURL += StringUtils::Format(":%i", m_iPort);
+
+  // a bare query still needs the root path in front of it
+  return strURL + "/" + m_strFileName;
+}
+
+CURL CURL::Resolve(const std::string& strLocation) const
+{
+  if (strLocation.find("://") != std::string::npos)
+    return CURL(strLocation);
+
+  // scheme relative, "//host/path"
+  if (StringUtils::StartsWith(strLocation, "//"))
+    return CURL(m_strProtocol + ":" + strLocation);
+
+  std::string strBase = m_strProtocol + "://" + m_strHostName;
+  if (m_iPort != 0)
+    strBase += StringUtils::Format(":%i", m_iPort);
+
+  // absolute path, "/path"
+  if (StringUtils::StartsWith(strLocation, "/"))
+    return CURL(strBase + strLocation);
+
+  // only the query changes, "?query"
+  std::string strPath = m_strFileName.substr(0, m_strFileName.find('?'));
+  if (StringUtils::StartsWith(strLocation, "?"))
+    return CURL(strBase + "/" + strPath + strLocation);
+
+  // relative to the directory of the current path
+  size_t iSlash = strPath.rfind('/');
+  strPath = iSlash == std::string::npos ? "" : strPath.substr(0, iSlash + 1);
+  return CURL(strBase + "/" + strPath + strLocation);
+}
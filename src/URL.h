@@ -0,0 +1,51 @@
+/*
+ *  Copyright (C) 2025-2025
+ *  This file is part of XBMC - https://github.com/antonic901/xbmc4xbox-redux
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+#include <string>
+
+/*!
+  \brief Splits an http(s) URL into the parts needed to send a request.
+*/
+class CURL
+{
+public:
+  CURL() = default;
+  explicit CURL(const std::string& strURL);
+  ~CURL() = default;
+
+  void Parse(const std::string& strURL);
+
+  /*!
+    \brief A URL the downloader can fetch: https on the default port.
+  */
+  bool IsValid() const;
+
+  const std::string& GetProtocol() const { return m_strProtocol; }
+  const std::string& GetHostName() const { return m_strHostName; }
+  int GetPort() const { return m_iPort; }
+
+  /*!
+    \brief Path and query without the leading slash.
+  */
+  const std::string& GetFileName() const { return m_strFileName; }
+
+  std::string Get() const;
+
+  /*!
+    \brief Resolves a Location header value, absolute or relative, against this URL.
+  */
+  CURL Resolve(const std::string& strLocation) const;
+
+private:
+  std::string m_strProtocol;
+  std::string m_strHostName;
+  std::string m_strFileName;
+  int m_iPort = 0;
+};
@@ -8,21 +8,56 @@
 
 #include "Updater.h"
 
+#if defined(UPDATER_BENCHMARK)
+#include "Benchmark.h"
+#endif
 #include "Downloader.h"
+#include "URL.h"
 #include "Util.h"
 #include "filesystem/HDDirectory.h"
 #include "filesystem/HDFile.h"
+#include "filesystem/TarExtractor.h"
+#include "network/DNSCache.h"
+#include "network/HTTPCache.h"
+#include "network/HTTPConnection.h"
+#include "network/RequestLog.h"
+#include "network/TLSContext.h"
+#include "network/TLSSessionCache.h"
 #include "utils/CustomLaunch.h"
 #include "utils/JSONVariantParser.h"
+#include "utils/StreamBuffer.h"
 #include "utils/StringUtils.h"
 
+#include <algorithm>
 #include <stdio.h>
-#include <fstream>
 #include <hal/debug.h>
 #include <windows.h>
 
-#include <microtar/microtar.h>
 
+// copies the part of the archive an earlier run left in the checkpoint into the stream
+static bool ReplayCheckpoint(const std::string& strPath, long long from, long long to, CStreamBuffer& stream)
+{
+  // the downloader holds the file open for writing
+  HANDLE hFile = CreateFileA(strPath.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (hFile == INVALID_HANDLE_VALUE)
+    return false;
+
+  LARGE_INTEGER position;
+  position.QuadPart = from;
+  bool bResult = SetFilePointerEx(hFile, position, NULL, FILE_BEGIN) != 0;
+
+  char buffer[16 * 1024];
+  while (bResult && from < to)
+  {
+    DWORD dwRead = 0;
+    const DWORD length = static_cast<DWORD>(std::min<long long>(to - from, sizeof(buffer)));
+    bResult = ReadFile(hFile, buffer, length, &dwRead, NULL) && dwRead == length && stream.Write(buffer, length);
+    from += length;
+  }
+
+  CloseHandle(hFile);
+  return bResult;
+}
 
 CUpdater::CUpdater(std::string strRootPath)
 {
@@ -64,33 +99,85 @@ int CUpdater::Process()
   }
 }
 
-std::string CUpdater::FindAsset(const std::string& strAsset) const
+std::string CUpdater::GetReleaseURL() const
 {
-  std::string strBody;
-  std::string strURL = StringUtils::Format("https://api.github.com/repos/antonic901/xbmc4xbox-redux/releases/tags/%s", m_updateChannel.c_str());
-  CDownloader downloader;
-  if (!downloader.Get(strURL, strBody) || strBody.empty())
-    return "";
-
-  CVariant data;
-  if (!CJSONVariantParser::Parse(strBody, data))
-    return "";
+  return StringUtils::Format("https://api.github.com/repos/antonic901/xbmc4xbox-redux/releases/tags/%s", m_updateChannel.c_str());
+}
 
-  if (data.isMember("assets") && data["assets"].isArray())
+std::string CUpdater::FindAsset(const std::string& strAsset)
+{
+  // the release is only fetched and parsed once per run
+  if (m_assets.empty())
   {
-    for (auto it = data["assets"].begin_array(); it != data["assets"].end_array(); ++it)
+    const std::string strReleaseURL = GetReleaseURL();
+    std::string strBody;
+    CDownloader downloader;
+    if (!downloader.Get(strReleaseURL, strBody) || strBody.empty())
+      return "";
+
+    // an unchanged release reuses the assets resolved when it was first fetched
+    std::string strIndex;
+    if (downloader.IsNotModified() && CHTTPCache::GetIndex(strReleaseURL, strIndex))
+    {
+      for (const std::string& strLine : StringUtils::Split(strIndex, '\n'))
+      {
+        const size_t pos = strLine.find('\t');
+        if (pos != std::string::npos)
+          m_assets[strLine.substr(0, pos)] = strLine.substr(pos + 1);
+      }
+    }
+
+    if (m_assets.empty())
     {
-      if (it->isObject() && it->isMember("url") && it->isMember("name"))
+      CVariant data;
+      if (!CJSONVariantParser::Parse(strBody, data))
+        return "";
+
+      if (data.isMember("assets") && data["assets"].isArray())
       {
-        std::string url = (*it)["url"].asString();
-        std::string name =(*it)["name"].asString();
-        if (StringUtils::EqualsNoCase(name, strAsset))
-          return url;
+        for (auto it = data["assets"].begin_array(); it != data["assets"].end_array(); ++it)
+        {
+          if (it->isObject() && it->isMember("url") && it->isMember("name"))
+          {
+            std::string name = (*it)["name"].asString();
+            StringUtils::ToLower(name);
+            m_assets[name] = (*it)["url"].asString();
+          }
+        }
       }
+
+      strIndex.clear();
+      for (const auto& asset : m_assets)
+        strIndex += asset.first + "\t" + asset.second + "\n";
+      CHTTPCache::SetIndex(strReleaseURL, strIndex);
     }
   }
 
-  return "";
+  std::string strName(strAsset);
+  StringUtils::ToLower(strName);
+  auto it = m_assets.find(strName);
+  return it != m_assets.end() ? it->second : "";
+}
+
+void CUpdater::SaveTLSSessions() const
+{
+  CTLSSessionCache::Save(GetCachePath() + "tls_sessions.dat");
+  printf("TLS handshakes: %u resumed, %u full\n", CTLSSessionCache::GetResumedHandshakes(), CTLSSessionCache::GetFullHandshakes());
+}
+
+void CUpdater::ShowRequestTimings() const
+{
+  for (const RequestTimings& timings : CRequestLog::Take())
+  {
+    CURL url(timings.url);
+    if (timings.reused)
+      debugPrint("%i %s: ttfb %.0f ms, %.0f ms total, %llu KB\n", timings.status, url.GetHostName().c_str(),
+                 timings.firstByte, timings.total, timings.received / 1024);
+    else
+      debugPrint("%i %s: dns %.0f, tcp %.0f, tls %.0f (kex %.0f, auth %.0f), ttfb %.0f ms, %.0f ms total, %llu KB\n",
+                 timings.status, url.GetHostName().c_str(), timings.dns, timings.connect, timings.handshake,
+                 timings.keyExchange, timings.authentication, timings.firstByte, timings.total, timings.received / 1024);
+  }
 }
 
 int CUpdater::Prepare()
@@ -109,13 +196,56 @@ int CUpdater::Prepare()
     return 1;
   }
 
+  // resolve the hosts while the TLS context is set up and the API request runs, release
+  // assets redirect to either of the CDN hosts
+  CDNSCache::Prefetch("api.github.com");
+  CDNSCache::Prefetch("objects.githubusercontent.com");
+  CDNSCache::Prefetch("release-assets.githubusercontent.com");
+
   m_updateChannel = launch.GetUpdateChannel();
+  m_downloadSegments = launch.GetDownloadSegments();
+  m_bStreamExtract = launch.GetStreamExtract();
+  m_bCheckpoint = launch.GetCheckpoint();
+  if (launch.GetReadSize() > 0)
+    CDownloader::SetReadSize(launch.GetReadSize());
+  if (launch.GetExtractBufferSize() > 0)
+    CTarExtractor::SetBufferSize(launch.GetExtractBufferSize());
+  CTarExtractor::SetPreallocate(launch.GetPreallocate());
+  CTarExtractor::SetWriterCount(launch.GetExtractWriters());
+  CTLSContext::SetMaxFragmentLength(launch.GetMaxFragmentLength());
+  CHTTPConnection::SetTimeouts(launch.GetConnectTimeout(), launch.GetFirstByteTimeout(), launch.GetIdleTimeout());
+  CRequestLog::SetEnabled(launch.GetRequestTimings());
+  if (!launch.GetGroups().empty() && !CTLSContext::SetGroups(launch.GetGroups()))
+    printf("Ignoring unsupported groups: %s\n", launch.GetGroups().c_str());
+  if (!launch.GetSignatureAlgorithms().empty() && !CTLSContext::SetSignatureAlgorithms(launch.GetSignatureAlgorithms()))
+    printf("Ignoring unsupported signature algorithms: %s\n", launch.GetSignatureAlgorithms().c_str());
+
+  // keep the TLS context alive for the whole run so every CDownloader shares it
+  m_tlsContext = CTLSContext::Get();
+  if (!m_tlsContext->IsValid())
+  {
+    m_strError = "failed to initialize TLS";
+    return 1;
+  }
+
+  // sessions from the previous run let the first handshakes resume
+  CHDDirectory::Create(GetCachePath());
+  CTLSSessionCache::Load(GetCachePath() + "tls_sessions.dat");
+  CRequestLog::SetPath(GetCachePath() + "requests.log");
+
+#if defined(UPDATER_BENCHMARK)
+  CBenchmark::Run(GetReleaseURL());
+#endif
+
+  // enabled after the benchmarks so they measure real transfers
+  CHTTPCache::SetPath(GetCachePath() + "http");
 
   m_strExtractPath = m_strRootPath;
   CUtil::RemoveSlashAtEnd(m_strExtractPath);
   m_strExtractPath += "_NEW";
   CUtil::AddSlashAtEnd(m_strExtractPath);
-  m_strUpdatePath = "Z:\\XBMC4Xbox.tar";
+  // kept in the cache folder so an interrupted download can be resumed on the next run
+  m_strUpdatePath = GetCachePath() + "XBMC4Xbox.tar";
 
   m_status = UpdaterStatus::CHECK_FOR_UPDATE;
   return 0;
@@ -132,19 +262,19 @@ int CUpdater::CheckForUpdate()
     return 1;
   }
 
+  std::string strVersion;
   CDownloader downloader;
-  if (!downloader.Download(strAssetLink, "Z:\\version.txt"))
+  if (!downloader.Get(strAssetLink, strVersion, "application/octet-stream"))
   {
     m_strError = StringUtils::Format("failed to download asset: %s", strAsset.c_str());
     return 1;
   }
 
-  std::ifstream file("Z:\\version.txt", std::ios::in);
-  if (file.is_open())
-  {
-    std::getline(file, m_latestRevision);
-    file.close();
-  }
+  SaveTLSSessions();
+  ShowRequestTimings();
+
+  m_latestRevision = strVersion.substr(0, strVersion.find_first_of("\r\n"));
+  StringUtils::Trim(m_latestRevision);
 
   if (m_latestRevision.empty() || m_currentRevision.empty())
   {
@@ -176,101 +306,98 @@ int CUpdater::Download()
     return 1;
   }
 
+  if (m_bStreamExtract)
+    return DownloadAndExtract(strAssetLink);
+
   CDownloader downloader;
-  if (!downloader.Download(strAssetLink, "Z:\\XBMC4Xbox.tar"))
+  if (!downloader.Download(strAssetLink, m_strUpdatePath, m_downloadSegments))
   {
     m_strError = "failed to download update";
     return 1;
   }
+  SaveTLSSessions();
+  ShowRequestTimings();
 
   debugPrint("SUCCESS\n");
   m_status = UpdaterStatus::EXTRACT_BUILD;
   return 0;
 }
 
-int CUpdater::Extract()
+int CUpdater::DownloadAndExtract(const std::string& strAssetLink)
 {
-  debugPrint("Extracting update...\n");
-  mtar_t tar;
-  int ret = mtar_open(&tar, m_strUpdatePath.c_str(), "r");
-  if (ret != MTAR_ESUCCESS)
+  // the extractor unpacks entries on its own thread while the rest of the archive arrives
+  CStreamBuffer stream;
+  CTarExtractor extractor(m_strExtractPath);
+  if (!extractor.Start(stream))
   {
-    m_strError = StringUtils::Format("%s %s", mtar_strerror(ret), m_strUpdatePath.c_str());
+    m_strError = extractor.GetError();
     return 1;
   }
 
-  std::string strLongPath;
-  char buffer[4096];
-  mtar_header_t header;
-  while ((mtar_read_header(&tar, &header)) != MTAR_ENULLRECORD)
-  {
-    std::string strFile;
-    if (!strLongPath.empty())
-    {
-      strFile = m_strExtractPath + strLongPath;
-      strLongPath.clear();
-    }
-    else
+  // without a checkpoint nothing but the extracted files goes to the disk, but an
+  // interrupted stream can't be picked up by the next run
+  const std::string strCheckpoint = m_bCheckpoint ? m_strUpdatePath : "";
+  long long streamed = 0;
+  bool bStreaming = true;
+  CDownloader downloader;
+  bool bResult = downloader.Download(strAssetLink, strCheckpoint, 1, [&](long long offset, const char* data, size_t size) {
+    if (bStreaming && offset > streamed && !strCheckpoint.empty())
     {
-      strFile = m_strExtractPath + header.name;
+      bStreaming = ReplayCheckpoint(strCheckpoint, streamed, offset, stream);
+      streamed = offset;
     }
-    StringUtils::Replace(strFile, "/", "\\");
-    StringUtils::Replace(strFile, "BUILD\\", "");
 
-    if (strcmp(header.name, "././@LongLink") == 0)
+    // a download that started over or skipped ahead can't be streamed any more
+    if (bStreaming && (offset != streamed || !stream.Write(data, size)))
     {
-      char longPath[MAX_PATH];
-      mtar_read_data(&tar, longPath, header.size);
-      longPath[header.size] = '\0';
-      strLongPath = longPath;
-      memset(longPath, 0, sizeof(longPath));
-      mtar_next(&tar);
-      continue;
+      bStreaming = false;
+      stream.Close();
     }
 
-    if (CUtil::HasSlashAtEnd(strFile))
-    {
-      if (!CHDDirectory::Create(strFile))
-      {
-        m_strError = "failed to extract archive";
-        mtar_close(&tar);
-        return 1;
-      }
-    }
-    else
-    {
-      if (CFileHD::Exists(strFile))
-      {
-        CFileHD::Delete(strFile);
-      }
+    if (!bStreaming)
+      return !strCheckpoint.empty();
 
-      FILE *destination_file = fopen(strFile.c_str(), "wb");
-      if (!destination_file)
-      {
-        m_strError = StringUtils::Format("failed to extract file: %s", strFile.c_str());
-        mtar_close(&tar);
-        return 1;
-      }
+    streamed += size;
+    return true;
+  });
+  stream.Close();
 
-      size_t remaining = header.size;
-      while (remaining > 0)
-      {
-        size_t chunk_size = (remaining < 4096) ? remaining : 4096;
-        ret = mtar_read_data(&tar, buffer, chunk_size);
-        if (ret != MTAR_ESUCCESS)
-        {
-          m_strError = StringUtils::Format("failed to extract file: %s", strFile.c_str());
-          mtar_close(&tar);
-          return 1;
-        }
+  const bool bExtracted = extractor.Wait();
+  SaveTLSSessions();
+  ShowRequestTimings();
 
-        fwrite(buffer, 1, chunk_size, destination_file);
-        remaining -= chunk_size;
-      }
+  // the end of archive marker arrived, anything after it doesn't matter
+  if (bExtracted)
+  {
+    debugPrint("SUCCESS\n");
+    debugPrint("Extracting completed!\n");
+    m_status = UpdaterStatus::COPY_USERDATA;
+    return 0;
+  }
 
-      fclose(destination_file);
-    }
-    mtar_next(&tar);
+  // without a checkpoint there is nothing to fall back to, and the download stops as soon
+  // as the extractor gave up
+  if (!bResult || strCheckpoint.empty())
+  {
+    m_strError = bStreaming ? "failed to download update" : extractor.GetError();
+    return 1;
+  }
+
+  // the whole archive is on the disk, unpack it from there
+  printf("Streaming extraction failed (%s), extracting %s\n", extractor.GetError().c_str(), strCheckpoint.c_str());
+  debugPrint("SUCCESS\n");
+  m_status = UpdaterStatus::EXTRACT_BUILD;
+  return 0;
+}
+
+int CUpdater::Extract()
+{
+  debugPrint("Extracting update...\n");
+  CTarExtractor extractor(m_strExtractPath);
+  if (!extractor.ExtractFile(m_strUpdatePath))
+  {
+    m_strError = extractor.GetError();
+    return 1;
   }
 
   m_status = UpdaterStatus::COPY_USERDATA;
@@ -314,6 +441,10 @@ int CUpdater::Install()
     return 1;
   }
 
+  // the archive has served its purpose, don't let the next update resume from it
+  CFileHD::Delete(m_strUpdatePath);
+  CFileHD::Delete(m_strUpdatePath + ".meta");
+
   m_status = UpdaterStatus::FINISHED;
   debugPrint("Install completed!\n");
   return 0;
@@ -8,8 +8,12 @@
 
 #pragma once
 
+#include <map>
+#include <memory>
 #include <string>
 
+class CTLSContext;
+
 enum class UpdaterStatus
 {
   PREPARE,
@@ -33,13 +37,22 @@ public:
 
   inline UpdaterStatus GetStatus() { return m_status; }
 
+  /*!
+    \brief Folder on the cache partition that survives between runs of the updater.
+  */
+  static std::string GetCachePath() { return "Z:\\updater\\"; }
+
 private:
   int Prepare();
   int CheckForUpdate();
   int Download();
+  int DownloadAndExtract(const std::string& strAssetLink);
   int Extract();
   int Install();
-  std::string FindAsset(const std::string& strAsset) const;
+  std::string GetReleaseURL() const;
+  std::string FindAsset(const std::string& strAsset);
+  void SaveTLSSessions() const;
+  void ShowRequestTimings() const;
 
   std::string m_strRootPath;
   std::string m_strUpdatePath;
@@ -48,8 +61,14 @@ private:
   std::string m_currentRevision;
   std::string m_latestRevision;
   std::string m_updateChannel;
+  unsigned int m_downloadSegments = 1;
+  bool m_bStreamExtract = false;
+  bool m_bCheckpoint = true;
+  std::map<std::string, std::string> m_assets;
 
   std::string m_strError;
 
+  std::shared_ptr<CTLSContext> m_tlsContext;
+
   UpdaterStatus m_status = UpdaterStatus::PREPARE;
 };
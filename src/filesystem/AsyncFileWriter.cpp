@@ -0,0 +1,140 @@
+/*
+ *  Copyright (C) 2025-2025
+ *  This file is part of XBMC - https://github.com/antonic901/xbmc4xbox-redux
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#include "AsyncFileWriter.h"
+
+#include "utils/Stopwatch.h"
+
+#include <algorithm>
+#include <string.h>
+
+// the thread does nothing but WriteFile
+static const SIZE_T WRITER_THREAD_STACK_SIZE = 16 * 1024;
+
+CAsyncFileWriter::CAsyncFileWriter(HANDLE hFile, size_t bufferSize, unsigned int bufferCount)
+  : m_hFile(hFile), m_buffers(std::max(bufferCount, 2u))
+{
+  for (Buffer& buffer : m_buffers)
+    buffer.data.resize(bufferSize);
+
+  const LONG count = static_cast<LONG>(m_buffers.size());
+  m_hFree = CreateSemaphore(NULL, count, count, NULL);
+  m_hFull = CreateSemaphore(NULL, 0, count, NULL);
+  if (m_hFree && m_hFull)
+    m_hThread = CreateThread(NULL, WRITER_THREAD_STACK_SIZE, WriterThread, this, 0, NULL);
+}
+
+CAsyncFileWriter::~CAsyncFileWriter()
+{
+  Close();
+}
+
+bool CAsyncFileWriter::Write(const char* data, size_t size)
+{
+  // without a writer thread the data goes straight to the file
+  if (!m_hThread)
+  {
+    DWORD dwWritten = 0;
+    if (!m_failed && (!WriteFile(m_hFile, data, size, &dwWritten, NULL) || dwWritten != size))
+      m_failed = true;
+    return !m_failed;
+  }
+
+  while (size > 0 && !m_failed)
+  {
+    // blocks while every buffer is queued for the disk
+    if (!m_filling)
+    {
+      // the clock only runs when the disk is actually behind
+      if (WaitForSingleObject(m_hFree, 0) == WAIT_TIMEOUT)
+      {
+        const long long start = CStopWatch::GetTicks();
+        WaitForSingleObject(m_hFree, INFINITE);
+        m_stallTicks += CStopWatch::GetTicks() - start;
+      }
+      m_buffers[m_head].size = 0;
+      m_filling = true;
+    }
+
+    Buffer& buffer = m_buffers[m_head];
+    const size_t length = std::min(size, buffer.data.size() - buffer.size);
+    memcpy(buffer.data.data() + buffer.size, data, length);
+    buffer.size += length;
+    data += length;
+    size -= length;
+
+    if (buffer.size == buffer.data.size())
+      Submit();
+  }
+
+  return !m_failed;
+}
+
+bool CAsyncFileWriter::Close()
+{
+  if (m_hThread)
+  {
+    if (m_filling && m_buffers[m_head].size > 0)
+      Submit();
+
+    // an empty buffer tells the thread to stop once everything before it is written
+    if (!m_filling)
+      WaitForSingleObject(m_hFree, INFINITE);
+    m_buffers[m_head].size = 0;
+    Submit();
+
+    WaitForSingleObject(m_hThread, INFINITE);
+    CloseHandle(m_hThread);
+    m_hThread = NULL;
+  }
+
+  if (m_hFree)
+  {
+    CloseHandle(m_hFree);
+    m_hFree = NULL;
+  }
+  if (m_hFull)
+  {
+    CloseHandle(m_hFull);
+    m_hFull = NULL;
+  }
+
+  return !m_failed;
+}
+
+void CAsyncFileWriter::Submit()
+{
+  m_head = (m_head + 1) % m_buffers.size();
+  m_filling = false;
+  ReleaseSemaphore(m_hFull, 1, NULL);
+}
+
+void CAsyncFileWriter::Process()
+{
+  while (true)
+  {
+    WaitForSingleObject(m_hFull, INFINITE);
+    const Buffer& buffer = m_buffers[m_tail];
+    m_tail = (m_tail + 1) % m_buffers.size();
+    if (buffer.size == 0)
+      break;
+
+    // after a failure the queue is still drained so Write() never waits forever
+    DWORD dwWritten = 0;
+    if (!m_failed && (!WriteFile(m_hFile, buffer.data.data(), buffer.size, &dwWritten, NULL) || dwWritten != buffer.size))
+      m_failed = true;
+
+    ReleaseSemaphore(m_hFree, 1, NULL);
+  }
+}
+
+DWORD WINAPI CAsyncFileWriter::WriterThread(LPVOID param)
+{
+  static_cast<CAsyncFileWriter*>(param)->Process();
+  return 0;
+}
@@ -0,0 +1,80 @@
+/*
+ *  Copyright (C) 2025-2025
+ *  This file is part of XBMC - https://github.com/antonic901/xbmc4xbox-redux
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <windows.h>
+
+/*!
+  \brief Write-behind file writer.
+
+  Data is copied into a ring of fixed size buffers which a dedicated thread
+  writes to the file, so the disk works while the caller receives the next
+  part. Memory use is bounded by the ring, Write() blocks once every buffer is
+  waiting for the disk.
+*/
+class CAsyncFileWriter
+{
+public:
+  /*!
+    \param hFile open file, positioned where the data goes. It stays owned by the caller.
+  */
+  CAsyncFileWriter(HANDLE hFile, size_t bufferSize = DEFAULT_BUFFER_SIZE, unsigned int bufferCount = DEFAULT_BUFFER_COUNT);
+  ~CAsyncFileWriter();
+
+  /*!
+    \brief Queues data for the writer thread.
+    \return false if an earlier write to the file failed
+  */
+  bool Write(const char* data, size_t size);
+
+  /*!
+    \brief Writes out whatever is still queued and stops the writer thread.
+    \return true if every byte ended up in the file
+  */
+  bool Close();
+
+  /*!
+    \brief Time Write() spent waiting for the disk to free a buffer, in performance counter ticks.
+  */
+  long long GetStallTicks() const { return m_stallTicks; }
+
+  static const size_t DEFAULT_BUFFER_SIZE = 64 * 1024;
+  static const unsigned int DEFAULT_BUFFER_COUNT = 4;
+
+private:
+  CAsyncFileWriter(const CAsyncFileWriter&) = delete;
+  CAsyncFileWriter& operator=(const CAsyncFileWriter&) = delete;
+
+  struct Buffer
+  {
+    std::vector<char> data;
+    size_t size = 0;
+  };
+
+  void Submit();
+  void Process();
+  static DWORD WINAPI WriterThread(LPVOID param);
+
+  HANDLE m_hFile;
+  std::vector<Buffer> m_buffers;
+  // next buffer the caller fills and next one the writer thread takes
+  unsigned int m_head = 0;
+  unsigned int m_tail = 0;
+  bool m_filling = false;
+  long long m_stallTicks = 0;
+
+  // count buffers ready to fill and buffers ready to write
+  HANDLE m_hFree = NULL;
+  HANDLE m_hFull = NULL;
+  HANDLE m_hThread = NULL;
+
+  std::atomic<bool> m_failed{false};
+};
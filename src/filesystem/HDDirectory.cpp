@@ -99,11 +99,14 @@ bool CHDDirectory::Remove(const std::string& strPath)
   return RemoveDirectoryA(path.c_str());
 }
 
-void CHDDirectory::WipeDir(const std::string& strPath)
+void CHDDirectory::WipeDir(const std::string& strPath, const std::string& strExclude)
 {
   std::string path(strPath);
   CUtil::AddSlashAtEnd(path);
 
+  std::string exclude(strExclude);
+  CUtil::RemoveSlashAtEnd(exclude);
+
   WIN32_FIND_DATA fd;
   HANDLE hFind = FindFirstFileA((path + "*.*").c_str(), &fd);
   if (hFind != INVALID_HANDLE_VALUE)
@@ -114,6 +117,9 @@ void CHDDirectory::WipeDir(const std::string& strPath)
         continue;
 
       std::string strFile = path + fd.cFileName;
+      if (!exclude.empty() && StringUtils::EqualsNoCase(strFile, exclude))
+        continue;
+
       if (fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
       {
         WipeDir(strFile);
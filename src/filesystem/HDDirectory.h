@@ -17,5 +17,5 @@ public:
   static bool Create(const std::string& path);
   static bool Exists(const std::string& strPath);
   static bool Remove(const std::string& strPath);
-  static void WipeDir(const std::string& strPath);
+  static void WipeDir(const std::string& strPath, const std::string& strExclude = "");
 };
@@ -43,4 +43,27 @@ bool CFileHD::Exists(const std::string& strFile)
 {
   const DWORD attrs = GetFileAttributesA(strFile.c_str());
   return attrs != INVALID_FILE_ATTRIBUTES && (attrs & FILE_ATTRIBUTE_DIRECTORY) == 0;
-}
\ No newline at end of file
+}
+
+long long CFileHD::GetSize(const std::string& strFile)
+{
+  HANDLE hFile = CreateFileA(strFile.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (hFile == INVALID_HANDLE_VALUE)
+    return -1;
+
+  LARGE_INTEGER size;
+  BOOL bResult = GetFileSizeEx(hFile, &size);
+  CloseHandle(hFile);
+  return bResult ? size.QuadPart : -1;
+}
+
+bool CFileHD::Preallocate(HANDLE hFile, long long size)
+{
+  LARGE_INTEGER position;
+  position.QuadPart = size;
+  if (!SetFilePointerEx(hFile, position, NULL, FILE_BEGIN) || !SetEndOfFile(hFile))
+    return false;
+
+  position.QuadPart = 0;
+  return SetFilePointerEx(hFile, position, NULL, FILE_BEGIN) != 0;
+}
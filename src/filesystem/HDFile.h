@@ -9,6 +9,7 @@
 #pragma once
 
 #include <string>
+#include <windows.h>
 
 class CFileHD
 {
@@ -18,4 +19,12 @@ public:
   static bool Delete(const std::string& strFile);
   static bool Rename(const std::string& strFile, const std::string& strDest);
   static bool Exists(const std::string& strFile);
+  static long long GetSize(const std::string& strFile);
+
+  /*!
+    \brief Sets the size of an open file before it is written, so FATX allocates all of
+    its clusters in one go instead of one FAT update per append.
+    \return false if the disk is full, the file pointer is back at the start otherwise
+  */
+  static bool Preallocate(HANDLE hFile, long long size);
 };
@@ -0,0 +1,523 @@
+/*
+ *  Copyright (C) 2025-2025
+ *  This file is part of XBMC - https://github.com/antonic901/xbmc4xbox-redux
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#include "TarExtractor.h"
+
+#include "Util.h"
+#include "filesystem/HDDirectory.h"
+#include "filesystem/HDFile.h"
+#include "threads/SingleLock.h"
+#include "utils/StreamBuffer.h"
+#include "utils/StringUtils.h"
+#include "utils/Stopwatch.h"
+
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+#include <utility>
+
+// file data goes through a buffer on the heap, this is for microtar and printf
+static const SIZE_T EXTRACT_THREAD_STACK_SIZE = 64 * 1024;
+// writers only create files and write them from the slots
+static const SIZE_T WRITER_THREAD_STACK_SIZE = 32 * 1024;
+
+const size_t CTarExtractor::MIN_BUFFER_SIZE;
+const size_t CTarExtractor::MAX_BUFFER_SIZE;
+const unsigned int CTarExtractor::MAX_WRITERS;
+size_t CTarExtractor::m_bufferSize = CTarExtractor::DEFAULT_BUFFER_SIZE;
+bool CTarExtractor::m_bPreallocate = true;
+unsigned int CTarExtractor::m_writerCount = CTarExtractor::DEFAULT_WRITERS;
+
+CTarExtractor::CTarExtractor(const std::string& strDestination)
+  : m_strDestination(strDestination)
+{
+}
+
+CTarExtractor::~CTarExtractor()
+{
+  Wait();
+}
+
+void CTarExtractor::SetBufferSize(size_t size)
+{
+  m_bufferSize = std::min(std::max(size, MIN_BUFFER_SIZE), MAX_BUFFER_SIZE) & ~(CLUSTER_SIZE - 1);
+}
+
+void CTarExtractor::SetWriterCount(unsigned int count)
+{
+  m_writerCount = std::min(count, MAX_WRITERS);
+}
+
+bool CTarExtractor::ExtractFile(const std::string& strPath)
+{
+  m_hFile = CreateFileA(strPath.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+  if (m_hFile == INVALID_HANDLE_VALUE)
+  {
+    m_strError = StringUtils::Format("%s %s", mtar_strerror(MTAR_EOPENFAIL), strPath.c_str());
+    return false;
+  }
+
+  const bool bResult = ExtractArchive();
+  CloseHandle(m_hFile);
+  m_hFile = INVALID_HANDLE_VALUE;
+  return bResult;
+}
+
+bool CTarExtractor::Start(CStreamBuffer& stream)
+{
+  m_stream = &stream;
+  m_bResult = false;
+  m_hThread = CreateThread(NULL, EXTRACT_THREAD_STACK_SIZE, ExtractThread, this, 0, NULL);
+  if (!m_hThread)
+  {
+    m_strError = "failed to start extracting";
+    return false;
+  }
+  return true;
+}
+
+bool CTarExtractor::Wait()
+{
+  if (!m_hThread)
+    return m_bResult;
+
+  WaitForSingleObject(m_hThread, INFINITE);
+  CloseHandle(m_hThread);
+  m_hThread = NULL;
+  return m_bResult;
+}
+
+DWORD WINAPI CTarExtractor::ExtractThread(LPVOID param)
+{
+  CTarExtractor* extractor = static_cast<CTarExtractor*>(param);
+  extractor->m_bResult = extractor->ExtractArchive();
+  // whatever follows the end of the archive is padding, don't let the producer wait for us
+  extractor->m_stream->Detach();
+  return 0;
+}
+
+bool CTarExtractor::ExtractArchive()
+{
+  // VirtualAlloc() hands out whole pages, which suits the disk better than the heap
+  const size_t bufferSize = m_bufferSize;
+  m_buffer = static_cast<char*>(VirtualAlloc(NULL, bufferSize, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE));
+  if (!m_buffer)
+  {
+    m_strError = "failed to extract archive: out of memory";
+    return false;
+  }
+
+  mtar_t tar;
+  memset(&tar, 0, sizeof(tar));
+  tar.read = ArchiveRead;
+  tar.seek = ArchiveSeek;
+  tar.close = ArchiveClose;
+  tar.stream = this;
+  m_position = 0;
+  m_bHeader = false;
+  m_extracted = 0;
+  m_writeTicks = 0;
+  m_failed = false;
+
+  CStopWatch watch;
+  watch.StartZero();
+  StartWriters();
+  const unsigned int writers = static_cast<unsigned int>(m_writers.size());
+  bool bResult = Extract(tar, bufferSize);
+  // files still queued are part of the extraction
+  StopWriters();
+  bResult = bResult && !m_failed;
+  const float seconds = watch.GetElapsedSeconds();
+  mtar_close(&tar);
+
+  VirtualFree(m_buffer, 0, MEM_RELEASE);
+  m_buffer = nullptr;
+
+  if (bResult)
+  {
+    const float megabytes = m_extracted / (1024.0f * 1024.0f);
+    const float writeSeconds = static_cast<float>(m_writeTicks) / static_cast<float>(CStopWatch::GetFrequency());
+    printf("Extracted %.2f MB in %.2f s (%.2f MB/s, %.2f s writing, %u KB buffer, %u writers%s)\n", megabytes,
+           seconds, seconds > 0.0f ? megabytes / seconds : 0.0f, writeSeconds, static_cast<unsigned int>(bufferSize / 1024),
+           writers, m_bPreallocate ? ", preallocated" : "");
+  }
+  return bResult;
+}
+
+bool CTarExtractor::ReadArchive(char* data, unsigned size)
+{
+  if (m_stream)
+    return m_stream->Read(data, size);
+
+  DWORD dwRead = 0;
+  return ReadFile(m_hFile, data, size, &dwRead, NULL) && dwRead == size;
+}
+
+bool CTarExtractor::SkipArchive(mtar_size_t length)
+{
+  if (!m_stream)
+  {
+    LARGE_INTEGER distance;
+    distance.QuadPart = static_cast<long long>(length);
+    if (!SetFilePointerEx(m_hFile, distance, NULL, FILE_CURRENT))
+      return false;
+    m_position += length;
+    return true;
+  }
+
+  char skip[BLOCK_SIZE];
+  while (length > 0)
+  {
+    const unsigned size = static_cast<unsigned>(std::min<mtar_size_t>(length, sizeof(skip)));
+    if (!m_stream->Read(skip, size))
+      return false;
+    m_position += size;
+    length -= size;
+  }
+  return true;
+}
+
+int CTarExtractor::ArchiveRead(mtar_t* tar, void* data, unsigned size)
+{
+  CTarExtractor* extractor = static_cast<CTarExtractor*>(tar->stream);
+  const mtar_size_t pos = tar->pos;
+
+  // microtar reads every header twice and returns to it once the data was read
+  if (extractor->m_bHeader && pos < extractor->m_position && pos >= extractor->m_headerPosition &&
+      pos - extractor->m_headerPosition + size <= BLOCK_SIZE)
+  {
+    memcpy(data, extractor->m_header + (pos - extractor->m_headerPosition), size);
+    return MTAR_ESUCCESS;
+  }
+
+  if (pos < extractor->m_position)
+    return MTAR_EREADFAIL;
+
+  // padding after the data of an entry
+  if (pos > extractor->m_position && !extractor->SkipArchive(pos - extractor->m_position))
+    return MTAR_EREADFAIL;
+
+  if (!extractor->ReadArchive(static_cast<char*>(data), size))
+    return MTAR_EREADFAIL;
+  extractor->m_position += size;
+
+  if (size == BLOCK_SIZE && pos == tar->last_header)
+  {
+    memcpy(extractor->m_header, data, BLOCK_SIZE);
+    extractor->m_headerPosition = pos;
+    extractor->m_bHeader = true;
+  }
+
+  return MTAR_ESUCCESS;
+}
+
+int CTarExtractor::ArchiveSeek(mtar_t* tar, mtar_size_t pos)
+{
+  // the next read starts at tar->pos, ArchiveRead() works out how to get there
+  (void)tar;
+  (void)pos;
+  return MTAR_ESUCCESS;
+}
+
+int CTarExtractor::ArchiveClose(mtar_t* tar)
+{
+  (void)tar;
+  return MTAR_ESUCCESS;
+}
+
+HANDLE CTarExtractor::CreateEntry(const std::string& strFile, mtar_size_t size)
+{
+  // CREATE_ALWAYS replaces a file left by an earlier attempt
+  HANDLE hFile = CreateFileA(strFile.c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS,
+                             FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+  if (hFile == INVALID_HANDLE_VALUE)
+  {
+    SetError(StringUtils::Format("failed to extract file: %s", strFile.c_str()));
+    return INVALID_HANDLE_VALUE;
+  }
+
+  // a full disk shows up here, before anything is written
+  if (m_bPreallocate && size > 0 && !CFileHD::Preallocate(hFile, static_cast<long long>(size)))
+  {
+    SetError(StringUtils::Format("failed to allocate file: %s", strFile.c_str()));
+    CloseHandle(hFile);
+    return INVALID_HANDLE_VALUE;
+  }
+
+  return hFile;
+}
+
+bool CTarExtractor::QueueEntry(mtar_t& tar, const std::string& strFile, unsigned size)
+{
+  // blocks while every slot waits for a writer
+  WaitForSingleObject(m_hFree, INFINITE);
+
+  Job job;
+  job.strFile = strFile;
+  job.size = size;
+  {
+    CSingleLock lock(m_critSection);
+    job.data = m_freeSlots.back();
+    m_freeSlots.pop_back();
+  }
+
+  if (size > 0 && mtar_read_data(&tar, job.data, size) != MTAR_ESUCCESS)
+  {
+    {
+      CSingleLock lock(m_critSection);
+      m_freeSlots.push_back(job.data);
+    }
+    ReleaseSemaphore(m_hFree, 1, NULL);
+    SetError(StringUtils::Format("failed to extract file: %s", strFile.c_str()));
+    return false;
+  }
+
+  {
+    CSingleLock lock(m_critSection);
+    m_jobs.push_back(std::move(job));
+  }
+  ReleaseSemaphore(m_hFull, 1, NULL);
+  m_extracted += size;
+  return true;
+}
+
+void CTarExtractor::SetError(const std::string& strError)
+{
+  // the first error is what went wrong, the rest follows from it
+  CSingleLock lock(m_critSection);
+  if (!m_failed)
+    m_strError = strError;
+  m_failed = true;
+}
+
+void CTarExtractor::StartWriters()
+{
+  if (m_writerCount == 0)
+    return;
+
+  const unsigned int slotCount = m_writerCount * 2;
+  m_slots = static_cast<char*>(VirtualAlloc(NULL, slotCount * SLOT_SIZE, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE));
+  m_hFree = CreateSemaphore(NULL, slotCount, slotCount, NULL);
+  m_hFull = CreateSemaphore(NULL, 0, slotCount + m_writerCount, NULL);
+  if (m_slots && m_hFree && m_hFull)
+  {
+    for (unsigned int i = 0; i < slotCount; ++i)
+      m_freeSlots.push_back(m_slots + i * SLOT_SIZE);
+
+    for (unsigned int i = 0; i < m_writerCount; ++i)
+    {
+      HANDLE hThread = CreateThread(NULL, WRITER_THREAD_STACK_SIZE, WriterThread, this, 0, NULL);
+      if (hThread)
+        m_writers.push_back(hThread);
+    }
+  }
+
+  // without writer threads every file is written on the reading thread
+  if (m_writers.empty())
+    StopWriters();
+}
+
+void CTarExtractor::StopWriters()
+{
+  if (!m_writers.empty())
+  {
+    // each empty job stops one writer once everything queued before it is written
+    {
+      CSingleLock lock(m_critSection);
+      m_jobs.insert(m_jobs.end(), m_writers.size(), Job());
+    }
+    ReleaseSemaphore(m_hFull, static_cast<LONG>(m_writers.size()), NULL);
+
+    for (HANDLE hThread : m_writers)
+    {
+      WaitForSingleObject(hThread, INFINITE);
+      CloseHandle(hThread);
+    }
+    m_writers.clear();
+  }
+
+  m_jobs.clear();
+  m_freeSlots.clear();
+  if (m_slots)
+  {
+    VirtualFree(m_slots, 0, MEM_RELEASE);
+    m_slots = nullptr;
+  }
+  if (m_hFree)
+  {
+    CloseHandle(m_hFree);
+    m_hFree = NULL;
+  }
+  if (m_hFull)
+  {
+    CloseHandle(m_hFull);
+    m_hFull = NULL;
+  }
+}
+
+void CTarExtractor::ProcessJobs()
+{
+  long long ticks = 0;
+  while (true)
+  {
+    WaitForSingleObject(m_hFull, INFINITE);
+    Job job;
+    {
+      CSingleLock lock(m_critSection);
+      job = std::move(m_jobs.front());
+      m_jobs.pop_front();
+    }
+    if (job.strFile.empty())
+      break;
+
+    // after a failure the queue is only drained, the extraction is abandoned anyway
+    if (!m_failed)
+    {
+      const long long start = CStopWatch::GetTicks();
+      HANDLE hFile = CreateEntry(job.strFile, job.size);
+      if (hFile != INVALID_HANDLE_VALUE)
+      {
+        DWORD dwWritten = 0;
+        if (job.size > 0 && (!WriteFile(hFile, job.data, job.size, &dwWritten, NULL) || dwWritten != job.size))
+          SetError(StringUtils::Format("failed to extract file: %s", job.strFile.c_str()));
+        CloseHandle(hFile);
+      }
+      ticks += CStopWatch::GetTicks() - start;
+    }
+
+    {
+      CSingleLock lock(m_critSection);
+      m_freeSlots.push_back(job.data);
+    }
+    ReleaseSemaphore(m_hFree, 1, NULL);
+  }
+
+  AddWriteTicks(ticks);
+}
+
+void CTarExtractor::AddWriteTicks(long long ticks)
+{
+  CSingleLock lock(m_critSection);
+  m_writeTicks += ticks;
+}
+
+DWORD WINAPI CTarExtractor::WriterThread(LPVOID param)
+{
+  static_cast<CTarExtractor*>(param)->ProcessJobs();
+  return 0;
+}
+
+bool CTarExtractor::Extract(mtar_t& tar, size_t bufferSize)
+{
+  std::string strLongPath;
+  mtar_header_t header;
+  int ret = MTAR_ESUCCESS;
+  while (!m_failed && (ret = mtar_read_header(&tar, &header)) == MTAR_ESUCCESS)
+  {
+    std::string strFile;
+    if (!strLongPath.empty())
+    {
+      strFile = m_strDestination + strLongPath;
+      strLongPath.clear();
+    }
+    else
+    {
+      strFile = m_strDestination + header.name;
+    }
+    StringUtils::Replace(strFile, "/", "\\");
+    StringUtils::Replace(strFile, "BUILD\\", "");
+
+    if (strcmp(header.name, "././@LongLink") == 0)
+    {
+      // the data is the name of the next entry, null terminated
+      char longPath[MAX_PATH];
+      if (header.size == 0 || header.size >= sizeof(longPath))
+      {
+        SetError("failed to extract archive: path too long");
+        return false;
+      }
+      ret = mtar_read_data(&tar, longPath, static_cast<unsigned>(header.size));
+      if (ret != MTAR_ESUCCESS)
+      {
+        SetError(StringUtils::Format("failed to extract archive: %s", mtar_strerror(ret)));
+        return false;
+      }
+      longPath[header.size] = '\0';
+      strLongPath = longPath;
+      mtar_next(&tar);
+      continue;
+    }
+
+    if (CUtil::HasSlashAtEnd(strFile))
+    {
+      // created before any entry after it is queued, so the writers always find it
+      if (!CHDDirectory::Create(strFile))
+      {
+        SetError("failed to extract archive");
+        return false;
+      }
+    }
+    else if (!m_writers.empty() && header.size <= SLOT_SIZE)
+    {
+      if (!QueueEntry(tar, strFile, static_cast<unsigned>(header.size)))
+        return false;
+    }
+    else
+    {
+      // writers may be adding their time as well, so it is summed up here first
+      long long ticks = 0;
+      long long start = CStopWatch::GetTicks();
+      HANDLE hDestination = CreateEntry(strFile, header.size);
+      if (hDestination == INVALID_HANDLE_VALUE)
+        return false;
+      ticks += CStopWatch::GetTicks() - start;
+
+      // microtar reads straight into the buffer, which goes to the disk as it is
+      mtar_size_t remaining = header.size;
+      while (remaining > 0)
+      {
+        const unsigned chunk = static_cast<unsigned>(std::min<mtar_size_t>(remaining, bufferSize));
+        bool bResult = mtar_read_data(&tar, m_buffer, chunk) == MTAR_ESUCCESS;
+
+        start = CStopWatch::GetTicks();
+        DWORD dwWritten = 0;
+        bResult = bResult && WriteFile(hDestination, m_buffer, chunk, &dwWritten, NULL) && dwWritten == chunk;
+        ticks += CStopWatch::GetTicks() - start;
+        if (!bResult)
+        {
+          SetError(StringUtils::Format("failed to extract file: %s", strFile.c_str()));
+          CloseHandle(hDestination);
+          return false;
+        }
+
+        remaining -= chunk;
+        m_extracted += chunk;
+      }
+
+      start = CStopWatch::GetTicks();
+      CloseHandle(hDestination);
+      ticks += CStopWatch::GetTicks() - start;
+      AddWriteTicks(ticks);
+    }
+    mtar_next(&tar);
+  }
+
+  // a writer failed, its error is already set
+  if (m_failed)
+    return false;
+
+  // anything but the end of archive marker means the archive is cut short or corrupt
+  if (ret != MTAR_ENULLRECORD)
+  {
+    SetError(StringUtils::Format("failed to extract archive: %s", mtar_strerror(ret)));
+    return false;
+  }
+
+  return true;
+}
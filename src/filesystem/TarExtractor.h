@@ -0,0 +1,170 @@
+/*
+ *  Copyright (C) 2025-2025
+ *  This file is part of XBMC - https://github.com/antonic901/xbmc4xbox-redux
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+#include "threads/CriticalSection.h"
+
+#include <atomic>
+#include <deque>
+#include <string>
+#include <vector>
+#include <windows.h>
+
+#include <microtar/microtar.h>
+
+class CStreamBuffer;
+
+/*!
+  \brief Unpacks a tar archive into a folder, either from a file or while it
+  is still arriving through a CStreamBuffer.
+
+  Custom read and seek functions are plugged into microtar. The archive is
+  consumed strictly in order: the only backwards seeks microtar makes are to
+  the header it just read, which is kept for that, and padding is skipped.
+
+  File data goes from the archive into one page aligned buffer and from there
+  straight to WriteFile(), without stdio in between. Each file is preallocated
+  to the size its header announces and written in whole clusters, only the
+  last write of a file can end inside one.
+
+  Most files of a build are a few KB and take longer to create than to write.
+  The thread reading the archive hands those to a pool of writer threads
+  through a bounded set of slots, so several files are created at once while
+  the next ones are read. Directories and large files stay on the reading
+  thread, which keeps every directory in place before the files that go into
+  it are queued.
+*/
+class CTarExtractor
+{
+public:
+  /*!
+    \param strDestination folder the entries are created in, ending with a slash
+  */
+  explicit CTarExtractor(const std::string& strDestination);
+  ~CTarExtractor();
+
+  bool ExtractFile(const std::string& strPath);
+
+  /*!
+    \brief Starts unpacking the stream on a thread of its own.
+    \return false if the thread couldn't be started
+  */
+  bool Start(CStreamBuffer& stream);
+
+  /*!
+    \brief Waits for the thread started by Start() to finish.
+    \return true if the whole archive was unpacked
+  */
+  bool Wait();
+
+  const std::string& GetError() const { return m_strError; }
+
+  /*!
+    \brief Size of the blocks file data is read and written in, rounded down to whole clusters.
+    Takes effect for extractions started afterwards.
+    \param size clamped between MIN_BUFFER_SIZE and MAX_BUFFER_SIZE
+  */
+  static void SetBufferSize(size_t size);
+  static size_t GetBufferSize() { return m_bufferSize; }
+
+  /*!
+    \brief Whether files are preallocated before they are written, on by default.
+  */
+  static void SetPreallocate(bool bPreallocate) { m_bPreallocate = bPreallocate; }
+  static bool GetPreallocate() { return m_bPreallocate; }
+
+  /*!
+    \brief Number of threads creating small files, 0 writes every file on the reading thread.
+    Takes effect for extractions started afterwards.
+    \param count clamped to MAX_WRITERS
+  */
+  static void SetWriterCount(unsigned int count);
+  static unsigned int GetWriterCount() { return m_writerCount; }
+
+  static const size_t MIN_BUFFER_SIZE = 64 * 1024;
+  static const size_t MAX_BUFFER_SIZE = 1024 * 1024;
+  static const size_t DEFAULT_BUFFER_SIZE = 256 * 1024;
+  static const unsigned int MAX_WRITERS = 8;
+  static const unsigned int DEFAULT_WRITERS = 0;
+
+private:
+  CTarExtractor(const CTarExtractor&) = delete;
+  CTarExtractor& operator=(const CTarExtractor&) = delete;
+
+  // a file for the writer threads, an empty path tells one of them to stop
+  struct Job
+  {
+    std::string strFile;
+    char* data = nullptr;
+    unsigned size = 0;
+  };
+
+  bool Extract(mtar_t& tar, size_t bufferSize);
+  bool ExtractArchive();
+  bool ReadArchive(char* data, unsigned size);
+  bool SkipArchive(mtar_size_t length);
+
+  HANDLE CreateEntry(const std::string& strFile, mtar_size_t size);
+  bool QueueEntry(mtar_t& tar, const std::string& strFile, unsigned size);
+  void SetError(const std::string& strError);
+  void AddWriteTicks(long long ticks);
+
+  void StartWriters();
+  void StopWriters();
+  void ProcessJobs();
+  static DWORD WINAPI WriterThread(LPVOID param);
+
+  static int ArchiveRead(mtar_t* tar, void* data, unsigned size);
+  static int ArchiveSeek(mtar_t* tar, mtar_size_t pos);
+  static int ArchiveClose(mtar_t* tar);
+  static DWORD WINAPI ExtractThread(LPVOID param);
+
+  static const unsigned int BLOCK_SIZE = 512;
+  // FATX cluster size of the stock partitions
+  static const size_t CLUSTER_SIZE = 16 * 1024;
+  // largest file handed to the writer threads, each one has two slots
+  static const size_t SLOT_SIZE = 64 * 1024;
+
+  std::string m_strDestination;
+  std::string m_strError;
+
+  // the archive is read from either of them
+  CStreamBuffer* m_stream = nullptr;
+  HANDLE m_hFile = INVALID_HANDLE_VALUE;
+  // bytes taken from the stream so far
+  mtar_size_t m_position = 0;
+  // copy of the last header read, microtar goes back to it
+  char m_header[BLOCK_SIZE];
+  mtar_size_t m_headerPosition = 0;
+  bool m_bHeader = false;
+
+  char* m_buffer = nullptr;
+  mtar_size_t m_extracted = 0;
+  // time spent creating, preallocating and writing files, in performance counter ticks
+  // summed over all threads
+  long long m_writeTicks = 0;
+
+  std::vector<HANDLE> m_writers;
+  char* m_slots = nullptr;
+  std::vector<char*> m_freeSlots;
+  std::deque<Job> m_jobs;
+  // count slots ready to fill and jobs ready to write
+  HANDLE m_hFree = NULL;
+  HANDLE m_hFull = NULL;
+  // guards the slots, the jobs, the error and m_writeTicks while writers run
+  CCriticalSection m_critSection;
+  std::atomic<bool> m_failed{false};
+
+  HANDLE m_hThread = NULL;
+  bool m_bResult = false;
+
+  static size_t m_bufferSize;
+  static bool m_bPreallocate;
+  static unsigned int m_writerCount;
+};
@@ -62,7 +62,7 @@ int main(void)
   nxMountDrive('Q', launchPath);
   nxMountDrive('Z', "\\Device\\Harddisk0\\Partition5\\");
 
-  CHDDirectory::WipeDir("Z:\\");
+  CHDDirectory::WipeDir("Z:\\", CUpdater::GetCachePath());
 
   CUpdater updater(strLaunchPath);
   while (true)
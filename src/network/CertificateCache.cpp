@@ -0,0 +1,116 @@
+/*
+ *  Copyright (C) 2025-2025
+ *  This file is part of XBMC - https://github.com/antonic901/xbmc4xbox-redux
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#include "CertificateCache.h"
+
+#include "threads/SingleLock.h"
+
+#include <ctype.h>
+#include <time.h>
+#include <windows.h>
+
+#include <mbedtls/sha256.h>
+
+// a handful of GitHub hosts, each with a certificate or two
+static const size_t MAX_ENTRIES = 16;
+
+std::map<std::pair<std::string, std::string>, CCertificateCache::Entry> CCertificateCache::m_entries;
+CCriticalSection CCertificateCache::m_critSection;
+
+static std::string MakeKey(const std::string& strHost)
+{
+  std::string strKey(strHost);
+  for (char& c : strKey)
+    c = ::tolower(c);
+  return strKey;
+}
+
+// mbedtls is built without MBEDTLS_HAVE_TIME_DATE and doesn't look at the validity period itself
+static bool IsExpired(const mbedtls_x509_time& validTo)
+{
+  const time_t now = time(NULL);
+  const struct tm* utc = gmtime(&now);
+  if (!utc)
+    return false;
+
+  const int current[] = { utc->tm_year + 1900, utc->tm_mon + 1, utc->tm_mday, utc->tm_hour, utc->tm_min, utc->tm_sec };
+  const int expires[] = { validTo.year, validTo.mon, validTo.day, validTo.hour, validTo.min, validTo.sec };
+  for (size_t i = 0; i < sizeof(current) / sizeof(current[0]); ++i)
+  {
+    if (current[i] != expires[i])
+      return current[i] > expires[i];
+  }
+  return false;
+}
+
+bool CCertificateCache::Fingerprint(const mbedtls_x509_crt* crt, std::string& strFingerprint)
+{
+  if (!crt || !crt->raw.p)
+    return false;
+
+  unsigned char hash[32];
+  if (mbedtls_sha256(crt->raw.p, crt->raw.len, hash, 0) != 0)
+    return false;
+
+  strFingerprint.assign(reinterpret_cast<const char*>(hash), sizeof(hash));
+  return true;
+}
+
+bool CCertificateCache::Contains(const std::string& strHost)
+{
+  const std::string strKey = MakeKey(strHost);
+
+  CSingleLock lock(m_critSection);
+  auto it = m_entries.lower_bound(std::make_pair(strKey, std::string()));
+  return it != m_entries.end() && it->first.first == strKey;
+}
+
+void CCertificateCache::Add(const std::string& strHost, const mbedtls_x509_crt* crt)
+{
+  std::string strFingerprint;
+  if (!Fingerprint(crt, strFingerprint) || IsExpired(crt->valid_to))
+    return;
+
+  CSingleLock lock(m_critSection);
+  auto key = std::make_pair(MakeKey(strHost), strFingerprint);
+  if (m_entries.find(key) == m_entries.end() && m_entries.size() >= MAX_ENTRIES)
+  {
+    auto oldest = m_entries.begin();
+    for (auto it = m_entries.begin(); it != m_entries.end(); ++it)
+    {
+      if (static_cast<long>(it->second.lastUsed - oldest->second.lastUsed) < 0)
+        oldest = it;
+    }
+    m_entries.erase(oldest);
+  }
+
+  Entry& entry = m_entries[key];
+  entry.validTo = crt->valid_to;
+  entry.lastUsed = GetTickCount();
+}
+
+bool CCertificateCache::Check(const std::string& strHost, const mbedtls_x509_crt* crt)
+{
+  std::string strFingerprint;
+  if (!Fingerprint(crt, strFingerprint))
+    return false;
+
+  CSingleLock lock(m_critSection);
+  auto it = m_entries.find(std::make_pair(MakeKey(strHost), strFingerprint));
+  if (it == m_entries.end())
+    return false;
+
+  if (IsExpired(it->second.validTo))
+  {
+    m_entries.erase(it);
+    return false;
+  }
+
+  it->second.lastUsed = GetTickCount();
+  return true;
+}
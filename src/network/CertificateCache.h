@@ -0,0 +1,61 @@
+/*
+ *  Copyright (C) 2025-2025
+ *  This file is part of XBMC - https://github.com/antonic901/xbmc4xbox-redux
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+#include "threads/CriticalSection.h"
+
+#include <map>
+#include <string>
+#include <utility>
+
+#include <mbedtls/x509_crt.h>
+
+/*!
+  \brief Remembers the server certificates whose chain was fully verified for a
+  host during this run. Later handshakes with the host skip the chain's signature
+  checks and only compare the server certificate's SHA-256 fingerprint against
+  the ones remembered here, see CTLSContext::GetPinnedConfig().
+
+  Entries are keyed by host and fingerprint, so a host that rotates between a
+  few certificates keeps all of them. An entry is dropped once its certificate
+  is past notAfter, and the least recently used one goes when the cache is full.
+*/
+class CCertificateCache
+{
+public:
+  CCertificateCache() = delete;
+
+  /*!
+    \brief Whether a certificate verified for the host is remembered.
+  */
+  static bool Contains(const std::string& strHost);
+
+  /*!
+    \brief Remembers the certificate after its chain was verified for the host.
+  */
+  static void Add(const std::string& strHost, const mbedtls_x509_crt* crt);
+
+  /*!
+    \brief Whether the certificate is one that was verified for the host and hasn't expired since.
+  */
+  static bool Check(const std::string& strHost, const mbedtls_x509_crt* crt);
+
+private:
+  struct Entry
+  {
+    mbedtls_x509_time validTo;
+    unsigned long lastUsed = 0;
+  };
+
+  static bool Fingerprint(const mbedtls_x509_crt* crt, std::string& strFingerprint);
+
+  // host and SHA-256 of the DER certificate
+  static std::map<std::pair<std::string, std::string>, Entry> m_entries;
+  static CCriticalSection m_critSection;
+};
@@ -0,0 +1,77 @@
+/*
+ *  Copyright (C) 2025-2025
+ *  This file is part of XBMC - https://github.com/antonic901/xbmc4xbox-redux
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#include "ConnectionPool.h"
+
+#include "network/TLSContext.h"
+#include "threads/SingleLock.h"
+#include "utils/StringUtils.h"
+
+#include <windows.h>
+
+// GitHub and its CDN keep idle connections open for at least this long
+static const unsigned long IDLE_TIMEOUT = 30 * 1000;
+static const size_t MAX_IDLE_CONNECTIONS = 4;
+
+std::vector<std::unique_ptr<CHTTPConnection>> CConnectionPool::m_idle;
+CCriticalSection CConnectionPool::m_critSection;
+
+std::unique_ptr<CHTTPConnection> CConnectionPool::Acquire(const std::string& strHost, bool bNew)
+{
+  // closing sends close_notify, which a stalled peer can hold up, so it happens after the lock is released
+  std::vector<std::unique_ptr<CHTTPConnection>> expired;
+  {
+    CSingleLock lock(m_critSection);
+    const unsigned long now = GetTickCount();
+    for (auto it = m_idle.begin(); it != m_idle.end();)
+    {
+      if ((*it)->GetIdleTime(now) > IDLE_TIMEOUT)
+      {
+        expired.push_back(std::move(*it));
+        it = m_idle.erase(it);
+        continue;
+      }
+
+      if (!bNew && StringUtils::EqualsNoCase((*it)->GetHost(), strHost))
+      {
+        std::unique_ptr<CHTTPConnection> connection = std::move(*it);
+        m_idle.erase(it);
+        return connection;
+      }
+
+      ++it;
+    }
+  }
+
+  // the handshake runs unlocked so other threads can connect at the same time
+  std::unique_ptr<CHTTPConnection> connection = std::make_unique<CHTTPConnection>(CTLSContext::Get());
+  if (!connection->Connect(strHost))
+    return nullptr;
+
+  return connection;
+}
+
+void CConnectionPool::Release(std::unique_ptr<CHTTPConnection> connection)
+{
+  if (!connection || !connection->IsConnected())
+    return;
+
+  connection->OnRequestDone();
+
+  // destroyed after the lock, see Acquire()
+  std::unique_ptr<CHTTPConnection> evicted;
+  CSingleLock lock(m_critSection);
+  m_idle.push_back(std::move(connection));
+
+  // drop the connection that has been idle the longest
+  if (m_idle.size() > MAX_IDLE_CONNECTIONS)
+  {
+    evicted = std::move(m_idle.front());
+    m_idle.erase(m_idle.begin());
+  }
+}
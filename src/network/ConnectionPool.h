@@ -0,0 +1,41 @@
+/*
+ *  Copyright (C) 2025-2025
+ *  This file is part of XBMC - https://github.com/antonic901/xbmc4xbox-redux
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+#include "network/HTTPConnection.h"
+#include "threads/CriticalSection.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+/*!
+  \brief Keeps finished HTTP/1.1 connections around so back-to-back requests to
+  the same host skip the TCP and TLS handshakes.
+*/
+class CConnectionPool
+{
+public:
+  CConnectionPool() = delete;
+
+  /*!
+    \brief Hands out an idle connection to the host, or opens a new one.
+    \param bNew always open a fresh connection, e.g. after a pooled one turned out stale
+  */
+  static std::unique_ptr<CHTTPConnection> Acquire(const std::string& strHost, bool bNew = false);
+
+  /*!
+    \brief Returns a connection whose last response was read completely.
+  */
+  static void Release(std::unique_ptr<CHTTPConnection> connection);
+
+private:
+  static std::vector<std::unique_ptr<CHTTPConnection>> m_idle;
+  static CCriticalSection m_critSection;
+};
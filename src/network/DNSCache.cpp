@@ -0,0 +1,184 @@
+/*
+ *  Copyright (C) 2025-2025
+ *  This file is part of XBMC - https://github.com/antonic901/xbmc4xbox-redux
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#include "DNSCache.h"
+
+#include "threads/SingleLock.h"
+
+#include <windows.h>
+
+#include <lwip/netdb.h>
+#include <lwip/sockets.h>
+
+// lwIP doesn't hand out the record TTL, GitHub's records live for a few minutes
+static const unsigned long DNS_TTL = 5 * 60 * 1000;
+// getaddrinfo runs lwIP's resolver on the calling thread, which needs little stack
+static const SIZE_T PREFETCH_THREAD_STACK_SIZE = 16 * 1024;
+
+std::map<std::string, CDNSCache::Entry> CDNSCache::m_entries;
+CCriticalSection CDNSCache::m_critSection;
+
+namespace
+{
+struct PrefetchRequest
+{
+  std::string strHost;
+  std::shared_ptr<void> done;
+};
+}
+
+bool CDNSCache::Resolve(const std::string& strHost, std::vector<std::string>& addresses)
+{
+  while (true)
+  {
+    std::shared_ptr<void> pending;
+    {
+      CSingleLock lock(m_critSection);
+      auto it = m_entries.find(strHost);
+      if (it != m_entries.end())
+      {
+        if (it->second.pending)
+        {
+          pending = it->second.pending;
+        }
+        else if (static_cast<long>(GetTickCount() - it->second.expires) < 0)
+        {
+          addresses = it->second.addresses;
+          return true;
+        }
+        else
+        {
+          m_entries.erase(it);
+        }
+      }
+    }
+
+    if (!pending)
+      break;
+
+    // the prefetch always finishes, lwIP's resolver gives up on its own
+    WaitForSingleObject(pending.get(), INFINITE);
+  }
+
+  if (!Lookup(strHost, addresses))
+    return false;
+
+  Store(strHost, addresses);
+  return true;
+}
+
+void CDNSCache::Forget(const std::string& strHost)
+{
+  CSingleLock lock(m_critSection);
+  auto it = m_entries.find(strHost);
+  // a running prefetch brings fresh addresses anyway
+  if (it != m_entries.end() && !it->second.pending)
+    m_entries.erase(it);
+}
+
+void CDNSCache::Prefetch(const std::string& strHost)
+{
+  PrefetchRequest* request = new PrefetchRequest;
+  request->strHost = strHost;
+  {
+    CSingleLock lock(m_critSection);
+    auto it = m_entries.find(strHost);
+    if (it != m_entries.end() && (it->second.pending || static_cast<long>(GetTickCount() - it->second.expires) < 0))
+    {
+      delete request;
+      return;
+    }
+
+    HANDLE hEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
+    if (!hEvent)
+    {
+      delete request;
+      return;
+    }
+
+    request->done = std::shared_ptr<void>(hEvent, CloseHandle);
+    Entry& entry = m_entries[strHost];
+    entry.addresses.clear();
+    entry.pending = request->done;
+  }
+
+  HANDLE hThread = CreateThread(NULL, PREFETCH_THREAD_STACK_SIZE, PrefetchThread, request, 0, NULL);
+  if (hThread)
+  {
+    CloseHandle(hThread);
+    return;
+  }
+
+  // nobody will resolve it in the background, Resolve() does it when needed
+  {
+    CSingleLock lock(m_critSection);
+    m_entries.erase(strHost);
+  }
+  SetEvent(request->done.get());
+  delete request;
+}
+
+DWORD WINAPI CDNSCache::PrefetchThread(LPVOID param)
+{
+  std::unique_ptr<PrefetchRequest> request(static_cast<PrefetchRequest*>(param));
+
+  std::vector<std::string> addresses;
+  const bool bResult = Lookup(request->strHost, addresses);
+  {
+    CSingleLock lock(m_critSection);
+    auto it = m_entries.find(request->strHost);
+    if (it != m_entries.end() && it->second.pending == request->done)
+    {
+      if (bResult)
+      {
+        it->second.addresses = addresses;
+        it->second.expires = GetTickCount() + DNS_TTL;
+        it->second.pending.reset();
+      }
+      else
+      {
+        m_entries.erase(it);
+      }
+    }
+  }
+
+  SetEvent(request->done.get());
+  return 0;
+}
+
+bool CDNSCache::Lookup(const std::string& strHost, std::vector<std::string>& addresses)
+{
+  struct addrinfo hints = {};
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+
+  struct addrinfo* result = NULL;
+  if (getaddrinfo(strHost.c_str(), NULL, &hints, &result) != 0 || !result)
+    return false;
+
+  addresses.clear();
+  for (const struct addrinfo* cur = result; cur != NULL; cur = cur->ai_next)
+  {
+    char address[INET_ADDRSTRLEN];
+    const struct sockaddr_in* addr = reinterpret_cast<const struct sockaddr_in*>(cur->ai_addr);
+    if (inet_ntop(AF_INET, &addr->sin_addr, address, sizeof(address)) != NULL)
+      addresses.push_back(address);
+  }
+  freeaddrinfo(result);
+
+  return !addresses.empty();
+}
+
+void CDNSCache::Store(const std::string& strHost, const std::vector<std::string>& addresses)
+{
+  CSingleLock lock(m_critSection);
+  Entry& entry = m_entries[strHost];
+  // a prefetch started meanwhile finishes into the same entry
+  entry.addresses = addresses;
+  entry.expires = GetTickCount() + DNS_TTL;
+}
@@ -0,0 +1,60 @@
+/*
+ *  Copyright (C) 2025-2025
+ *  This file is part of XBMC - https://github.com/antonic901/xbmc4xbox-redux
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+#include "threads/CriticalSection.h"
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+/*!
+  \brief Resolves host names to IPv4 addresses and remembers the answers for a
+  while. Hosts we know we'll need can be looked up on a background thread ahead
+  of time, so the DNS round trip is over by the time the connection is opened.
+*/
+class CDNSCache
+{
+public:
+  CDNSCache() = delete;
+
+  /*!
+    \brief Looks up the host, waiting for a prefetch of it that is still running.
+    \param addresses receives every address of the host in dotted notation, in the order the resolver gave them
+  */
+  static bool Resolve(const std::string& strHost, std::vector<std::string>& addresses);
+
+  /*!
+    \brief Drops what is known about the host, so the next Resolve() asks the resolver again.
+    Called when none of its addresses could be reached.
+  */
+  static void Forget(const std::string& strHost);
+
+  /*!
+    \brief Starts resolving the host in the background unless it is already known.
+  */
+  static void Prefetch(const std::string& strHost);
+
+private:
+  struct Entry
+  {
+    std::vector<std::string> addresses;
+    unsigned long expires = 0;
+    // set while a prefetch is running, signaled once it finished
+    std::shared_ptr<void> pending;
+  };
+
+  static bool Lookup(const std::string& strHost, std::vector<std::string>& addresses);
+  static void Store(const std::string& strHost, const std::vector<std::string>& addresses);
+  static DWORD WINAPI PrefetchThread(LPVOID param);
+
+  static std::map<std::string, Entry> m_entries;
+  static CCriticalSection m_critSection;
+};
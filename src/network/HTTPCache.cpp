@@ -0,0 +1,136 @@
+/*
+ *  Copyright (C) 2025-2025
+ *  This file is part of XBMC - https://github.com/antonic901/xbmc4xbox-redux
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#include "HTTPCache.h"
+
+#include "Util.h"
+#include "filesystem/HDDirectory.h"
+#include "utils/StringUtils.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+static const char CACHE_FILE_MAGIC[4] = { 'X', 'H', 'T', 'C' };
+static const uint32_t CACHE_FILE_VERSION = 2;
+// release JSON is a few hundred KB at most, refuse anything that looks corrupt
+static const uint32_t MAX_FIELD_SIZE = 4 * 1024 * 1024;
+
+std::string CHTTPCache::m_strPath;
+
+static bool ReadField(FILE* file, std::string& strField)
+{
+  uint32_t size = 0;
+  if (fread(&size, sizeof(size), 1, file) != 1 || size > MAX_FIELD_SIZE)
+    return false;
+
+  strField.resize(size);
+  return size == 0 || fread(&strField[0], size, 1, file) == 1;
+}
+
+static bool WriteField(FILE* file, const std::string& strField)
+{
+  const uint32_t size = strField.size();
+  return fwrite(&size, sizeof(size), 1, file) == 1 && (size == 0 || fwrite(strField.data(), size, 1, file) == 1);
+}
+
+void CHTTPCache::SetPath(const std::string& strPath)
+{
+  m_strPath = strPath;
+  CUtil::AddSlashAtEnd(m_strPath);
+  CHDDirectory::Create(m_strPath);
+}
+
+std::string CHTTPCache::GetFileName(const std::string& strURL)
+{
+  // FATX names are limited to 42 characters, so files are named after a hash of the URL
+  uint32_t hash = 0x811C9DC5;
+  for (unsigned char c : strURL)
+  {
+    hash ^= c;
+    hash *= 0x01000193;
+  }
+  return m_strPath + StringUtils::Format("%08x.dat", hash);
+}
+
+bool CHTTPCache::ReadHeader(FILE* file, const std::string& strURL, Entry& entry)
+{
+  char magic[4];
+  uint32_t version = 0;
+  std::string strStoredURL;
+  return fread(magic, sizeof(magic), 1, file) == 1 && memcmp(magic, CACHE_FILE_MAGIC, sizeof(magic)) == 0 &&
+         fread(&version, sizeof(version), 1, file) == 1 && version == CACHE_FILE_VERSION &&
+         ReadField(file, strStoredURL) && strStoredURL == strURL &&
+         ReadField(file, entry.etag) &&
+         ReadField(file, entry.lastModified) &&
+         ReadField(file, entry.index);
+}
+
+bool CHTTPCache::Get(const std::string& strURL, Entry& entry)
+{
+  if (m_strPath.empty())
+    return false;
+
+  FILE* file = fopen(GetFileName(strURL).c_str(), "rb");
+  if (!file)
+    return false;
+
+  bool bResult = ReadHeader(file, strURL, entry) && ReadField(file, entry.body);
+
+  fclose(file);
+  return bResult;
+}
+
+bool CHTTPCache::GetIndex(const std::string& strURL, std::string& strIndex)
+{
+  if (m_strPath.empty())
+    return false;
+
+  FILE* file = fopen(GetFileName(strURL).c_str(), "rb");
+  if (!file)
+    return false;
+
+  // the body comes last, so it is never read
+  Entry entry;
+  bool bResult = ReadHeader(file, strURL, entry);
+
+  fclose(file);
+  if (bResult)
+    strIndex = std::move(entry.index);
+  return bResult;
+}
+
+bool CHTTPCache::Set(const std::string& strURL, const Entry& entry)
+{
+  if (m_strPath.empty())
+    return false;
+
+  FILE* file = fopen(GetFileName(strURL).c_str(), "wb");
+  if (!file)
+    return false;
+
+  bool bResult = fwrite(CACHE_FILE_MAGIC, sizeof(CACHE_FILE_MAGIC), 1, file) == 1 &&
+                 fwrite(&CACHE_FILE_VERSION, sizeof(CACHE_FILE_VERSION), 1, file) == 1 &&
+                 WriteField(file, strURL) &&
+                 WriteField(file, entry.etag) &&
+                 WriteField(file, entry.lastModified) &&
+                 WriteField(file, entry.index) &&
+                 WriteField(file, entry.body);
+
+  return fclose(file) == 0 && bResult;
+}
+
+bool CHTTPCache::SetIndex(const std::string& strURL, const std::string& strIndex)
+{
+  Entry entry;
+  if (!Get(strURL, entry))
+    return false;
+
+  entry.index = strIndex;
+  return Set(strURL, entry);
+}
@@ -0,0 +1,53 @@
+/*
+ *  Copyright (C) 2025-2025
+ *  This file is part of XBMC - https://github.com/antonic901/xbmc4xbox-redux
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+#include <stdio.h>
+#include <string>
+
+/*!
+  \brief On-disk cache of small GET responses keyed by URL.
+
+  Entries keep the validators the server sent, so the next request can be
+  made conditional and a 304 Not Modified answered from the stored body.
+  Callers can keep what they extracted from the body in the same entry, so
+  an unchanged document doesn't have to be parsed again.
+  Nothing is cached until a folder is set with SetPath().
+*/
+class CHTTPCache
+{
+public:
+  struct Entry
+  {
+    std::string etag;
+    std::string lastModified;
+    // what the caller extracted from the body, empty until SetIndex()
+    std::string index;
+    std::string body;
+  };
+
+  CHTTPCache() = delete;
+
+  static void SetPath(const std::string& strPath);
+
+  static bool Get(const std::string& strURL, Entry& entry);
+  static bool Set(const std::string& strURL, const Entry& entry);
+
+  /*!
+    \brief Reads only the index of an entry, without loading the body.
+  */
+  static bool GetIndex(const std::string& strURL, std::string& strIndex);
+  static bool SetIndex(const std::string& strURL, const std::string& strIndex);
+
+private:
+  static std::string GetFileName(const std::string& strURL);
+  static bool ReadHeader(FILE* file, const std::string& strURL, Entry& entry);
+
+  static std::string m_strPath;
+};
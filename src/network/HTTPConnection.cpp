@@ -0,0 +1,272 @@
+/*
+ *  Copyright (C) 2025-2025
+ *  This file is part of XBMC - https://github.com/antonic901/xbmc4xbox-redux
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#include "HTTPConnection.h"
+
+#include "network/CertificateCache.h"
+#include "network/DNSCache.h"
+#include "network/RequestLog.h"
+#include "network/TLSContext.h"
+#include "network/TLSSessionCache.h"
+#include "utils/Stopwatch.h"
+
+#include <stdio.h>
+#include <windows.h>
+
+#include "mbedtls/glue.h"
+
+unsigned long CHTTPConnection::m_connectTimeout = 10 * 1000;
+unsigned long CHTTPConnection::m_firstByteTimeout = 30 * 1000;
+unsigned long CHTTPConnection::m_idleTimeout = 30 * 1000;
+
+// the handshake state a step starts in tells what the step spends its time on
+static long long& HandshakeBucket(CHTTPConnection::ConnectTimes& times, int state)
+{
+  switch (state)
+  {
+  case MBEDTLS_SSL_CLIENT_HELLO:
+  case MBEDTLS_SSL_SERVER_HELLO:
+  case MBEDTLS_SSL_CLIENT_KEY_EXCHANGE:
+    return times.keyExchange;
+  case MBEDTLS_SSL_SERVER_CERTIFICATE:
+  case MBEDTLS_SSL_SERVER_KEY_EXCHANGE:
+  case MBEDTLS_SSL_CERTIFICATE_VERIFY:
+    return times.authentication;
+  case MBEDTLS_SSL_CLIENT_CHANGE_CIPHER_SPEC:
+  case MBEDTLS_SSL_CLIENT_FINISHED:
+  case MBEDTLS_SSL_SERVER_CHANGE_CIPHER_SPEC:
+  case MBEDTLS_SSL_SERVER_FINISHED:
+    return times.finished;
+  default:
+    return times.other;
+  }
+}
+
+CHTTPConnection::CHTTPConnection(std::shared_ptr<CTLSContext> context)
+  : m_context(std::move(context))
+{
+  mbedtls_net_init(&m_net);
+  mbedtls_ssl_init(&m_ssl);
+}
+
+CHTTPConnection::~CHTTPConnection()
+{
+  Close();
+  mbedtls_ssl_free(&m_ssl);
+}
+
+bool CHTTPConnection::Connect(const std::string& strHost)
+{
+  if (!m_context || !m_context->IsValid())
+    return false;
+
+  m_strHost = strHost;
+
+  const bool bPinned = CCertificateCache::Contains(strHost);
+  bool bRejected = false;
+  if (Open(bPinned, bRejected))
+    return true;
+  if (!bRejected)
+    return false;
+
+  // the server presented a certificate we haven't seen, verify its chain after all
+  printf("Certificate of %s changed, verifying it\n", strHost.c_str());
+  mbedtls_ssl_free(&m_ssl);
+  mbedtls_ssl_init(&m_ssl);
+  return Open(false, bRejected);
+}
+
+bool CHTTPConnection::Open(bool bPinned, bool& bRejected)
+{
+  const std::string& strHost = m_strHost;
+
+  if (mbedtls_ssl_setup(&m_ssl, bPinned ? m_context->GetPinnedConfig() : m_context->GetConfig()) != 0)
+    return false;
+
+  if (mbedtls_ssl_set_hostname(&m_ssl, strHost.c_str()) != 0)
+    return false;
+
+  const DWORD start = GetTickCount();
+  m_connectTimes = ConnectTimes();
+  m_connectTimes.start = CStopWatch::GetTicks();
+
+  // the name is only needed for SNI and certificate checks, the socket goes to the cached addresses
+  std::vector<std::string> addresses;
+  if (!CDNSCache::Resolve(strHost, addresses))
+    return false;
+
+  // try every address like a plain connect by name would, the time of any that failed counts as tcp
+  bool bConnected = false;
+  for (size_t i = 0; i < addresses.size() && !bConnected; i++)
+    bConnected = mbedtls_net_connect_timeout(&m_net, addresses[i].c_str(), "443", MBEDTLS_NET_PROTO_TCP, m_connectTimeout,
+                                             i == 0 ? &m_connectTimes.resolved : NULL) == 0;
+  if (!bConnected)
+  {
+    // the host may have moved, don't keep handing out addresses nobody answers on
+    CDNSCache::Forget(strHost);
+    return false;
+  }
+  m_connectTimes.connected = CStopWatch::GetTicks();
+
+  mbedtls_ssl_set_bio(&m_ssl, &m_net, mbedtls_net_send, mbedtls_net_recv, NULL);
+
+  std::vector<unsigned char> offered;
+  CTLSSessionCache::Restore(strHost, &m_ssl, offered);
+
+  // step through the handshake ourselves to time each step
+  while (!mbedtls_ssl_is_handshake_over(&m_ssl))
+  {
+    // the state is private to mbedtls and its values change between releases, it
+    // only decides where the timing breakdown puts a step and nothing else
+    const int state = m_ssl.MBEDTLS_PRIVATE(state);
+
+    const long long stepStart = CStopWatch::GetTicks();
+    int ret = mbedtls_ssl_handshake_step(&m_ssl);
+    const long long stepEnd = CStopWatch::GetTicks();
+    HandshakeBucket(m_connectTimes, state) += stepEnd - stepStart;
+    if (ret == 0)
+      continue;
+
+    // the TLS handshake shares the connect timeout with the TCP one
+    const DWORD elapsed = GetTickCount() - start;
+    if ((ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) ||
+        elapsed >= m_connectTimeout || !Wait(ret, m_connectTimeout - elapsed))
+    {
+      mbedtls_net_free(&m_net);
+      return false;
+    }
+    m_connectTimes.network += CStopWatch::GetTicks() - stepEnd;
+  }
+
+  m_connectTimes.handshakeDone = CStopWatch::GetTicks();
+
+  // a resumed session was checked when it was first negotiated
+  const bool bResumed = CTLSSessionCache::IsResumed(&m_ssl, offered);
+  if (!bResumed)
+  {
+    const mbedtls_x509_crt* peer = mbedtls_ssl_get_peer_cert(&m_ssl);
+    if (!bPinned)
+    {
+      CCertificateCache::Add(strHost, peer);
+    }
+    else if (!CCertificateCache::Check(strHost, peer))
+    {
+      bRejected = true;
+      mbedtls_ssl_close_notify(&m_ssl);
+      mbedtls_net_free(&m_net);
+      return false;
+    }
+  }
+
+  CTLSSessionCache::OnHandshake(bResumed);
+
+  if (CRequestLog::IsEnabled())
+  {
+    const float frequency = CStopWatch::GetFrequency() / 1000.0f;
+    printf("TLS handshake with %s (%s, %s): key exchange %.1f ms, authentication %.1f ms, finished %.1f ms, other %.1f ms, network %.1f ms\n",
+           strHost.c_str(), mbedtls_ssl_get_ciphersuite(&m_ssl), !bResumed ? (bPinned ? "pinned" : "full") : "resumed",
+           m_connectTimes.keyExchange / frequency, m_connectTimes.authentication / frequency,
+           m_connectTimes.finished / frequency, m_connectTimes.other / frequency, m_connectTimes.network / frequency);
+  }
+
+  // TLS 1.3 servers hand out tickets after the handshake, see Read()
+  if (mbedtls_ssl_get_version_number(&m_ssl) != MBEDTLS_SSL_VERSION_TLS1_3)
+    CTLSSessionCache::Store(strHost, &m_ssl);
+
+  m_connected = true;
+  m_lastUsed = GetTickCount();
+  return true;
+}
+
+void CHTTPConnection::Close()
+{
+  if (!m_connected)
+    return;
+
+  mbedtls_ssl_close_notify(&m_ssl);
+  mbedtls_net_free(&m_net);
+  m_connected = false;
+}
+
+void CHTTPConnection::SetTimeouts(unsigned long connect, unsigned long firstByte, unsigned long idle)
+{
+  m_connectTimeout = connect;
+  m_firstByteTimeout = firstByte;
+  m_idleTimeout = idle;
+}
+
+bool CHTTPConnection::Wait(int ret, unsigned long timeout)
+{
+  const uint32_t rw = ret == MBEDTLS_ERR_SSL_WANT_WRITE ? MBEDTLS_NET_POLL_WRITE : MBEDTLS_NET_POLL_READ;
+  return mbedtls_net_poll(&m_net, rw, timeout) > 0;
+}
+
+bool CHTTPConnection::Write(const char* data, size_t size)
+{
+  while (size > 0)
+  {
+    int ret = mbedtls_ssl_write(&m_ssl, (const unsigned char *)data, size);
+    if (ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE)
+    {
+      if (!Wait(ret, m_idleTimeout))
+        return false;
+      continue;
+    }
+
+    if (ret <= 0)
+      return false;
+
+    data += ret;
+    size -= ret;
+    m_bytesWritten += ret;
+  }
+
+  // the server gets longer to come up with the start of its answer
+  m_waitingForResponse = true;
+  return true;
+}
+
+int CHTTPConnection::Read(char* buffer, size_t size)
+{
+  int ret;
+  while (true)
+  {
+    ret = mbedtls_ssl_read(&m_ssl, (unsigned char *)buffer, size);
+    if (ret == MBEDTLS_ERR_SSL_RECEIVED_NEW_SESSION_TICKET)
+    {
+      CTLSSessionCache::Store(m_strHost, &m_ssl);
+      continue;
+    }
+
+    if (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE)
+      break;
+
+    if (!Wait(ret, m_waitingForResponse ? m_firstByteTimeout : m_idleTimeout))
+      return MBEDTLS_ERR_SSL_TIMEOUT;
+  }
+
+  if (ret > 0)
+  {
+    if (m_waitingForResponse)
+      m_firstByteTime = CStopWatch::GetTicks();
+    m_waitingForResponse = false;
+    m_bytesRead += ret;
+  }
+
+  // an orderly shutdown by the server is just the end of the stream
+  if (ret == MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY)
+    return 0;
+
+  return ret;
+}
+
+void CHTTPConnection::OnRequestDone()
+{
+  m_requests++;
+  m_lastUsed = GetTickCount();
+}
@@ -0,0 +1,127 @@
+/*
+ *  Copyright (C) 2025-2025
+ *  This file is part of XBMC - https://github.com/antonic901/xbmc4xbox-redux
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include <mbedtls/net_sockets.h>
+#include <mbedtls/ssl.h>
+
+class CTLSContext;
+
+/*!
+  \brief A single TLS connection to a host which can carry several HTTP/1.1
+  requests one after another.
+*/
+class CHTTPConnection
+{
+public:
+  CHTTPConnection(std::shared_ptr<CTLSContext> context);
+  ~CHTTPConnection();
+
+  bool Connect(const std::string& strHost);
+  void Close();
+
+  bool Write(const char* data, size_t size);
+
+  /*!
+    \brief Reads the next part of the response.
+    \return number of bytes read, 0 at the end of the stream, a negative mbedtls
+    error on failure or MBEDTLS_ERR_SSL_TIMEOUT when the server went quiet
+  */
+  int Read(char* buffer, size_t size);
+
+  bool IsConnected() const { return m_connected; }
+  const std::string& GetHost() const { return m_strHost; }
+
+  /*!
+    \brief Number of requests completed on this connection so far. Anything
+    above zero means the server may have dropped it while it sat idle.
+  */
+  unsigned int GetRequestCount() const { return m_requests; }
+  void OnRequestDone();
+  unsigned long GetIdleTime(unsigned long now) const { return now - m_lastUsed; }
+
+  /*!
+    \brief Limits in milliseconds on how long a connection waits for the TCP and TLS
+    handshake, for the first byte of a response after a request was sent, and for
+    any further data of a response.
+  */
+  static void SetTimeouts(unsigned long connect, unsigned long firstByte, unsigned long idle);
+
+  /*!
+    \brief Performance counter values taken while the connection was opened, and
+    how many ticks of the TLS handshake went to each kind of work.
+  */
+  struct ConnectTimes
+  {
+    long long start = 0;
+    long long resolved = 0;
+    long long connected = 0;
+    long long handshakeDone = 0;
+
+    // key shares and the ECDHE secret
+    long long keyExchange = 0;
+    // certificate chain and the server's signature over the handshake
+    long long authentication = 0;
+    // key schedule and Finished messages
+    long long finished = 0;
+    // everything else, mostly parsing hellos and extensions
+    long long other = 0;
+    // waiting for the server
+    long long network = 0;
+  };
+  const ConnectTimes& GetConnectTimes() const { return m_connectTimes; }
+
+  /*!
+    \brief Performance counter value when the first byte of the last response arrived.
+  */
+  long long GetFirstByteTime() const { return m_firstByteTime; }
+
+  unsigned long long GetBytesWritten() const { return m_bytesWritten; }
+  unsigned long long GetBytesRead() const { return m_bytesRead; }
+
+private:
+  CHTTPConnection(const CHTTPConnection&) = delete;
+  CHTTPConnection& operator=(const CHTTPConnection&) = delete;
+
+  /*!
+    \brief Waits until the socket can make progress on what mbedtls asked for.
+    \param ret MBEDTLS_ERR_SSL_WANT_READ or MBEDTLS_ERR_SSL_WANT_WRITE
+    \return false if nothing happened within the timeout
+  */
+  bool Wait(int ret, unsigned long timeout);
+
+  /*!
+    \brief Opens the TCP connection and does the TLS handshake with m_strHost.
+    \param bPinned skip the chain verification, the server certificate has to be in CCertificateCache
+    \param bRejected set when the handshake went through but the certificate is not the cached one
+  */
+  bool Open(bool bPinned, bool& bRejected);
+
+  std::shared_ptr<CTLSContext> m_context;
+  mbedtls_net_context m_net;
+  mbedtls_ssl_context m_ssl;
+
+  std::string m_strHost;
+  unsigned long m_lastUsed = 0;
+  unsigned int m_requests = 0;
+  bool m_connected = false;
+  bool m_waitingForResponse = false;
+
+  ConnectTimes m_connectTimes;
+  long long m_firstByteTime = 0;
+  unsigned long long m_bytesWritten = 0;
+  unsigned long long m_bytesRead = 0;
+
+  static unsigned long m_connectTimeout;
+  static unsigned long m_firstByteTimeout;
+  static unsigned long m_idleTimeout;
+};
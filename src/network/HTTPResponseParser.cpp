@@ -0,0 +1,395 @@
+/*
+ *  Copyright (C) 2025-2025
+ *  This file is part of XBMC - https://github.com/antonic901/xbmc4xbox-redux
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#include "HTTPResponseParser.h"
+
+#include <algorithm>
+#include <limits.h>
+#include <string.h>
+
+// refuse responses whose header alone would not fit in a sane amount of memory
+static const size_t MAX_HEADER_SIZE = 64 * 1024;
+
+static inline char ToLower(char c)
+{
+  return c >= 'A' && c <= 'Z' ? c + ('a' - 'A') : c;
+}
+
+static bool EqualsNoCase(const char* str, size_t size, const char* literal)
+{
+  const size_t length = strlen(literal);
+  if (size != length)
+    return false;
+
+  for (size_t i = 0; i < size; ++i)
+  {
+    if (ToLower(str[i]) != literal[i])
+      return false;
+  }
+  return true;
+}
+
+static bool EndsWithNoCase(const char* str, size_t size, const char* literal)
+{
+  const size_t length = strlen(literal);
+  return size >= length && EqualsNoCase(str + size - length, length, literal);
+}
+
+static int HexValue(char c)
+{
+  if (c >= '0' && c <= '9')
+    return c - '0';
+  if (c >= 'a' && c <= 'f')
+    return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F')
+    return c - 'A' + 10;
+  return -1;
+}
+
+// parses the decimal number at str and advances it past the digits, -1 if there is none or it overflows
+static long long ParseDecimal(const char*& str, const char* end)
+{
+  long long value = 0;
+  const char* start = str;
+  for (; str < end && *str >= '0' && *str <= '9'; ++str)
+  {
+    if (value > (LLONG_MAX - (*str - '0')) / 10)
+      return -1;
+    value = value * 10 + (*str - '0');
+  }
+  return str == start ? -1 : value;
+}
+
+// true if the comma separated header value contains the token
+static bool HasToken(const char* value, size_t size, const char* token)
+{
+  const char* end = value + size;
+  while (value < end)
+  {
+    const char* comma = static_cast<const char*>(memchr(value, ',', end - value));
+    const char* tokenEnd = comma ? comma : end;
+    const char* first = value;
+    const char* last = tokenEnd;
+    while (first < last && (*first == ' ' || *first == '\t'))
+      ++first;
+    while (last > first && (last[-1] == ' ' || last[-1] == '\t'))
+      --last;
+
+    if (EqualsNoCase(first, last - first, token))
+      return true;
+
+    value = tokenEnd + 1;
+  }
+  return false;
+}
+
+CHTTPResponseParser::CHTTPResponseParser(HTTPResponse& response, BodyCallback onBody)
+  : m_response(response), m_onBody(std::move(onBody))
+{
+}
+
+size_t CHTTPResponseParser::Parse(const char* data, size_t size)
+{
+  m_received += size;
+
+  const char* p = data;
+  const char* end = data + size;
+  while (p < end && m_state != State::DONE && m_state != State::FAILED)
+  {
+    switch (m_state)
+    {
+    case State::STATUS_LINE:
+    case State::HEADER_LINE:
+    {
+      const char* newline = static_cast<const char*>(memchr(p, '\n', end - p));
+      const size_t length = (newline ? newline : end) - p;
+      m_headerSize += length + 1;
+      if (m_headerSize > MAX_HEADER_SIZE)
+      {
+        m_state = State::FAILED;
+        break;
+      }
+
+      // only a line split across two reads has to be copied
+      if (!newline)
+      {
+        m_line.append(p, length);
+        p = end;
+        break;
+      }
+
+      bool bResult;
+      if (m_line.empty())
+      {
+        bResult = ParseLine(p, length);
+      }
+      else
+      {
+        m_line.append(p, length);
+        bResult = ParseLine(m_line.data(), m_line.size());
+        m_line.clear();
+      }
+
+      p = newline + 1;
+      if (!bResult)
+        m_state = State::FAILED;
+      break;
+    }
+    case State::BODY:
+    case State::CHUNK_DATA:
+    {
+      const size_t length = static_cast<size_t>(std::min<long long>(m_remaining, end - p));
+      if (!m_onBody(p, length))
+      {
+        m_state = State::FAILED;
+        break;
+      }
+
+      p += length;
+      m_remaining -= length;
+      if (m_remaining == 0)
+        m_state = m_state == State::BODY ? State::DONE : State::CHUNK_DATA_END;
+      break;
+    }
+    case State::BODY_UNTIL_CLOSE:
+      if (!m_onBody(p, end - p))
+      {
+        m_state = State::FAILED;
+        break;
+      }
+      p = end;
+      break;
+    case State::CHUNK_SIZE:
+    {
+      const int digit = HexValue(*p);
+      if (digit >= 0)
+      {
+        if (m_remaining > (LLONG_MAX >> 4))
+        {
+          m_state = State::FAILED;
+          break;
+        }
+        m_remaining = (m_remaining << 4) | digit;
+        m_chunkDigits = true;
+        ++p;
+      }
+      else
+      {
+        // whatever follows the size, extensions or the line end, is skipped
+        m_state = m_chunkDigits ? State::CHUNK_EXTENSION : State::FAILED;
+      }
+      break;
+    }
+    case State::CHUNK_EXTENSION:
+    {
+      const char* newline = static_cast<const char*>(memchr(p, '\n', end - p));
+      if (!newline)
+      {
+        p = end;
+        break;
+      }
+
+      p = newline + 1;
+      m_state = m_remaining == 0 ? State::TRAILER_LINE_START : State::CHUNK_DATA;
+      break;
+    }
+    case State::CHUNK_DATA_END:
+      if (*p == '\r')
+      {
+        ++p;
+      }
+      else if (*p == '\n')
+      {
+        ++p;
+        m_remaining = 0;
+        m_chunkDigits = false;
+        m_state = State::CHUNK_SIZE;
+      }
+      else
+      {
+        m_state = State::FAILED;
+      }
+      break;
+    case State::TRAILER_LINE_START:
+      if (*p == '\r')
+      {
+        ++p;
+      }
+      else if (*p == '\n')
+      {
+        ++p;
+        m_state = State::DONE;
+      }
+      else
+      {
+        m_state = State::TRAILER_LINE;
+      }
+      break;
+    case State::TRAILER_LINE:
+    {
+      const char* newline = static_cast<const char*>(memchr(p, '\n', end - p));
+      p = newline ? newline + 1 : end;
+      if (newline)
+        m_state = State::TRAILER_LINE_START;
+      break;
+    }
+    case State::DONE:
+    case State::FAILED:
+      break;
+    }
+  }
+
+  return p - data;
+}
+
+bool CHTTPResponseParser::Finish()
+{
+  // without any framing the body ends when the server closes the connection
+  if (m_state == State::BODY_UNTIL_CLOSE)
+    m_state = State::DONE;
+
+  return m_state == State::DONE;
+}
+
+bool CHTTPResponseParser::ParseLine(const char* line, size_t size)
+{
+  if (size > 0 && line[size - 1] == '\r')
+    --size;
+
+  if (m_state == State::STATUS_LINE)
+  {
+    if (!ParseStatusLine(line, size))
+      return false;
+
+    m_state = State::HEADER_LINE;
+    return true;
+  }
+
+  if (size == 0)
+  {
+    OnHeadersDone();
+    return true;
+  }
+
+  const char* colon = static_cast<const char*>(memchr(line, ':', size));
+  if (!colon)
+    return true;
+
+  const char* value = colon + 1;
+  const char* end = line + size;
+  while (value < end && (*value == ' ' || *value == '\t'))
+    ++value;
+  while (end > value && (end[-1] == ' ' || end[-1] == '\t'))
+    --end;
+
+  ParseHeader(line, colon - line, value, end - value);
+  return true;
+}
+
+bool CHTTPResponseParser::ParseStatusLine(const char* line, size_t size)
+{
+  // "HTTP/1.1 200 OK"
+  if (size < 12 || memcmp(line, "HTTP/1.", 7) != 0 || line[8] != ' ')
+    return false;
+
+  const char* status = line + 9;
+  if (ParseDecimal(status, line + 12) < 0 || status != line + 12)
+    return false;
+
+  m_response.status = (line[9] - '0') * 100 + (line[10] - '0') * 10 + (line[11] - '0');
+  // HTTP/1.0 closes after every response unless told otherwise
+  m_response.keepAlive = line[7] != '0';
+  return true;
+}
+
+void CHTTPResponseParser::ParseHeader(const char* name, size_t nameSize, const char* value, size_t valueSize)
+{
+  const char* end = value + valueSize;
+  if (EqualsNoCase(name, nameSize, "content-length"))
+  {
+    const char* p = value;
+    long long length = ParseDecimal(p, end);
+    if (p != end || length < 0)
+      m_state = State::FAILED;
+    else
+      m_response.contentLength = length;
+  }
+  else if (EqualsNoCase(name, nameSize, "transfer-encoding"))
+  {
+    // chunked has to be the last coding applied
+    m_response.chunked = EndsWithNoCase(value, valueSize, "chunked");
+  }
+  else if (EqualsNoCase(name, nameSize, "connection"))
+  {
+    if (HasToken(value, valueSize, "close"))
+      m_response.keepAlive = false;
+    else if (HasToken(value, valueSize, "keep-alive"))
+      m_response.keepAlive = true;
+  }
+  else if (EqualsNoCase(name, nameSize, "location"))
+    m_response.location.assign(value, valueSize);
+  else if (EqualsNoCase(name, nameSize, "etag"))
+    m_response.etag.assign(value, valueSize);
+  else if (EqualsNoCase(name, nameSize, "last-modified"))
+    m_response.lastModified.assign(value, valueSize);
+  else if (EqualsNoCase(name, nameSize, "content-encoding"))
+    m_response.contentEncoding.assign(value, valueSize);
+  else if (EqualsNoCase(name, nameSize, "content-range"))
+  {
+    // "bytes <first>-<last>/<total>" on 206, "bytes */<total>" on 416
+    if (valueSize < 6 || !EqualsNoCase(value, 6, "bytes "))
+      return;
+
+    const char* p = value + 6;
+    if (p < end && *p != '*')
+      m_response.rangeStart = ParseDecimal(p, end);
+
+    const char* slash = static_cast<const char*>(memchr(p, '/', end - p));
+    if (slash)
+    {
+      p = slash + 1;
+      m_response.rangeTotal = ParseDecimal(p, end);
+    }
+  }
+}
+
+void CHTTPResponseParser::OnHeadersDone()
+{
+  m_headerSize = 0;
+
+  // an interim response like 100 Continue is followed by the real one
+  if (m_response.status >= 100 && m_response.status < 200)
+  {
+    std::string strURL = std::move(m_response.url);
+    m_response = HTTPResponse();
+    m_response.url = std::move(strURL);
+    m_state = State::STATUS_LINE;
+    return;
+  }
+
+  m_remaining = 0;
+  if (m_response.status == 204 || m_response.status == 304)
+  {
+    m_state = State::DONE;
+  }
+  else if (m_response.chunked)
+  {
+    m_chunkDigits = false;
+    m_state = State::CHUNK_SIZE;
+  }
+  else if (m_response.contentLength >= 0)
+  {
+    m_remaining = m_response.contentLength;
+    m_state = m_remaining == 0 ? State::DONE : State::BODY;
+  }
+  else
+  {
+    m_response.keepAlive = false;
+    m_state = State::BODY_UNTIL_CLOSE;
+  }
+}
@@ -0,0 +1,97 @@
+/*
+ *  Copyright (C) 2025-2025
+ *  This file is part of XBMC - https://github.com/antonic901/xbmc4xbox-redux
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+#include <functional>
+#include <string>
+
+struct HTTPResponse
+{
+  int status = 0;
+  long long contentLength = -1;
+  bool chunked = false;
+  bool keepAlive = true;
+  std::string url;
+  std::string location;
+  std::string etag;
+  std::string lastModified;
+  std::string contentEncoding;
+  long long rangeStart = -1;
+  long long rangeTotal = -1;
+};
+
+/*!
+  \brief Incremental HTTP/1.1 response parser.
+
+  Every received buffer is walked exactly once. Header lines are parsed where
+  they sit in the buffer and only a line split across two reads is buffered.
+  Body bytes, with any chunk framing removed, go straight from the buffer to
+  the sink.
+*/
+class CHTTPResponseParser
+{
+public:
+  typedef std::function<bool(const char* data, size_t size)> BodyCallback;
+
+  CHTTPResponseParser(HTTPResponse& response, BodyCallback onBody);
+  ~CHTTPResponseParser() = default;
+
+  /*!
+    \brief Feeds the next part of the response.
+    \return number of bytes consumed, less than size only once the response is complete
+  */
+  size_t Parse(const char* data, size_t size);
+
+  /*!
+    \brief Tells the parser the server closed the connection.
+    \return true if that ended the response normally
+  */
+  bool Finish();
+
+  bool IsDone() const { return m_state == State::DONE; }
+  bool IsFailed() const { return m_state == State::FAILED; }
+  bool HasData() const { return m_received > 0; }
+
+  /*!
+    \brief Body bytes still expected for a response with Content-Length, -1 otherwise.
+  */
+  long long GetRemaining() const { return m_state == State::BODY ? m_remaining : -1; }
+
+private:
+  enum class State
+  {
+    STATUS_LINE,
+    HEADER_LINE,
+    BODY,
+    BODY_UNTIL_CLOSE,
+    CHUNK_SIZE,
+    CHUNK_EXTENSION,
+    CHUNK_DATA,
+    CHUNK_DATA_END,
+    TRAILER_LINE_START,
+    TRAILER_LINE,
+    DONE,
+    FAILED
+  };
+
+  bool ParseLine(const char* line, size_t size);
+  bool ParseStatusLine(const char* line, size_t size);
+  void ParseHeader(const char* name, size_t nameSize, const char* value, size_t valueSize);
+  void OnHeadersDone();
+
+  HTTPResponse& m_response;
+  BodyCallback m_onBody;
+
+  State m_state = State::STATUS_LINE;
+  std::string m_line;
+  size_t m_headerSize = 0;
+  size_t m_received = 0;
+  long long m_remaining = 0;
+  bool m_chunkDigits = false;
+};
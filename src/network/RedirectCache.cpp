@@ -0,0 +1,47 @@
+/*
+ *  Copyright (C) 2025-2025
+ *  This file is part of XBMC - https://github.com/antonic901/xbmc4xbox-redux
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#include "RedirectCache.h"
+
+#include "threads/SingleLock.h"
+
+#include <windows.h>
+
+// the signed asset links GitHub hands out stay valid for a few minutes, stay well below that
+static const unsigned long REDIRECT_TTL = 60 * 1000;
+
+std::map<std::string, CRedirectCache::Entry> CRedirectCache::m_entries;
+CCriticalSection CRedirectCache::m_critSection;
+
+std::string CRedirectCache::Get(const std::string& strURL)
+{
+  CSingleLock lock(m_critSection);
+  auto it = m_entries.find(strURL);
+  if (it == m_entries.end())
+    return "";
+
+  if (static_cast<long>(GetTickCount() - it->second.expires) >= 0)
+  {
+    m_entries.erase(it);
+    return "";
+  }
+
+  return it->second.strTarget;
+}
+
+void CRedirectCache::Set(const std::string& strURL, const std::string& strTarget)
+{
+  CSingleLock lock(m_critSection);
+  m_entries[strURL] = { strTarget, GetTickCount() + REDIRECT_TTL };
+}
+
+void CRedirectCache::Remove(const std::string& strURL)
+{
+  CSingleLock lock(m_critSection);
+  m_entries.erase(strURL);
+}
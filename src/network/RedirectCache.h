@@ -0,0 +1,42 @@
+/*
+ *  Copyright (C) 2025-2025
+ *  This file is part of XBMC - https://github.com/antonic901/xbmc4xbox-redux
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+#include "threads/CriticalSection.h"
+
+#include <map>
+#include <string>
+
+/*!
+  \brief Remembers where a URL redirected to for a short while, so retries and
+  range requests for a release asset go straight to the CDN instead of asking
+  api.github.com again.
+*/
+class CRedirectCache
+{
+public:
+  CRedirectCache() = delete;
+
+  /*!
+    \return the final URL the request redirected to, or an empty string
+  */
+  static std::string Get(const std::string& strURL);
+  static void Set(const std::string& strURL, const std::string& strTarget);
+  static void Remove(const std::string& strURL);
+
+private:
+  struct Entry
+  {
+    std::string strTarget;
+    unsigned long expires;
+  };
+
+  static std::map<std::string, Entry> m_entries;
+  static CCriticalSection m_critSection;
+};
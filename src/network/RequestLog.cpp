@@ -0,0 +1,67 @@
+/*
+ *  Copyright (C) 2025-2025
+ *  This file is part of XBMC - https://github.com/antonic901/xbmc4xbox-redux
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#include "RequestLog.h"
+
+#include "threads/SingleLock.h"
+
+#include <stdio.h>
+
+bool CRequestLog::m_bEnabled = false;
+std::string CRequestLog::m_strPath;
+std::vector<RequestTimings> CRequestLog::m_pending;
+CCriticalSection CRequestLog::m_critSection;
+
+static std::string EscapeJSON(const std::string& str)
+{
+  std::string result;
+  result.reserve(str.size());
+  for (char c : str)
+  {
+    if (c == '"' || c == '\\')
+      result += '\\';
+    if (static_cast<unsigned char>(c) >= 0x20)
+      result += c;
+  }
+  return result;
+}
+
+void CRequestLog::SetPath(const std::string& strPath)
+{
+  CSingleLock lock(m_critSection);
+  m_strPath = strPath;
+}
+
+void CRequestLog::Add(const RequestTimings& timings)
+{
+  CSingleLock lock(m_critSection);
+  m_pending.push_back(timings);
+
+  if (m_strPath.empty())
+    return;
+
+  FILE* file = fopen(m_strPath.c_str(), "a");
+  if (!file)
+    return;
+
+  fprintf(file, "{\"url\":\"%s\",\"status\":%i,\"reused\":%s,\"dns_ms\":%.2f,\"connect_ms\":%.2f,"
+                "\"tls_ms\":%.2f,\"tls_kex_ms\":%.2f,\"tls_auth_ms\":%.2f,\"tls_finished_ms\":%.2f,"
+                "\"ttfb_ms\":%.2f,\"total_ms\":%.2f,\"sent\":%llu,\"received\":%llu}\n",
+          EscapeJSON(timings.url).c_str(), timings.status, timings.reused ? "true" : "false", timings.dns,
+          timings.connect, timings.handshake, timings.keyExchange, timings.authentication, timings.finished,
+          timings.firstByte, timings.total, timings.sent, timings.received);
+  fclose(file);
+}
+
+std::vector<RequestTimings> CRequestLog::Take()
+{
+  CSingleLock lock(m_critSection);
+  std::vector<RequestTimings> result;
+  result.swap(m_pending);
+  return result;
+}
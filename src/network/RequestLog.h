@@ -0,0 +1,68 @@
+/*
+ *  Copyright (C) 2025-2025
+ *  This file is part of XBMC - https://github.com/antonic901/xbmc4xbox-redux
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+#include "threads/CriticalSection.h"
+
+#include <string>
+#include <vector>
+
+/*!
+  \brief Where the time of a single request went. Phases that didn't happen,
+  like the handshakes on a reused connection, are -1.
+*/
+struct RequestTimings
+{
+  std::string url;
+  int status = 0;
+  bool reused = false;
+  float dns = -1.0f;
+  float connect = -1.0f;
+  float handshake = -1.0f;
+  // parts of the handshake, see CHTTPConnection::ConnectTimes
+  float keyExchange = -1.0f;
+  float authentication = -1.0f;
+  float finished = -1.0f;
+  float firstByte = -1.0f;
+  float total = 0.0f;
+  unsigned long long sent = 0;
+  unsigned long long received = 0;
+};
+
+/*!
+  \brief Collects RequestTimings for every request while enabled. Each one is
+  appended as a JSON line to the log file and kept until the caller takes it
+  for the on-screen summary.
+*/
+class CRequestLog
+{
+public:
+  CRequestLog() = delete;
+
+  /*!
+    \brief Requests are only timed while enabled, off by default.
+  */
+  static void SetEnabled(bool bEnabled) { m_bEnabled = bEnabled; }
+  static bool IsEnabled() { return m_bEnabled; }
+
+  static void SetPath(const std::string& strPath);
+
+  static void Add(const RequestTimings& timings);
+
+  /*!
+    \brief Returns the requests added since the last call.
+  */
+  static std::vector<RequestTimings> Take();
+
+private:
+  static bool m_bEnabled;
+  static std::string m_strPath;
+  static std::vector<RequestTimings> m_pending;
+  static CCriticalSection m_critSection;
+};
@@ -0,0 +1,404 @@
+/*
+ *  Copyright (C) 2025-2025
+ *  This file is part of XBMC - https://github.com/antonic901/xbmc4xbox-redux
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#include "TLSContext.h"
+
+#include "threads/SingleLock.h"
+#include "utils/StringUtils.h"
+#include "utils/Stopwatch.h"
+
+#include <algorithm>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <mbedtls/debug.h>
+#include <mbedtls/ecp.h>
+#include <mbedtls/platform.h>
+#include <mbedtls/threading.h>
+#include <psa/crypto.h>
+
+#if defined(UPDATER_DER_TRUST_STORE)
+// generated at build time by tools/make_truststore.py
+alignas(4) const unsigned char truststore[] = {
+#embed "assets/truststore.bin"
+};
+
+struct TrustStoreEntry
+{
+  uint32_t hash;
+  uint32_t offset;
+  uint32_t length;
+};
+
+static const size_t TRUST_STORE_HEADER_SIZE = 12;
+static const uint32_t TRUST_STORE_VERSION = 1;
+
+static uint32_t SubjectHash(const unsigned char *data, size_t len)
+{
+  uint32_t hash = 0x811C9DC5;
+  for (size_t i = 0; i < len; ++i)
+  {
+    hash ^= data[i];
+    hash *= 0x01000193;
+  }
+  return hash;
+}
+#else
+const unsigned char cert[] = {
+#embed "assets/cacert.pem" suffix(, ) // No suffix
+    0                                 // always null-terminated
+};
+#endif
+
+// without AES-NI, AES-GCM runs on lookup tables and a bit-serial GHASH, which the
+// Pentium III does several times slower than ChaCha20-Poly1305 in plain C. Servers
+// that honour the client's order pick ChaCha20, the AES suites remain for the rest.
+// Measure with the cipher benchmark (-DUPDATER_BENCHMARK=ON) before reordering.
+// Every entry below is guarded by the options it needs, so a trimmed configuration
+// such as my_mbedtls_config_lean.h never offers something it can't negotiate.
+static const int CIPHERSUITES[] = {
+#if defined(MBEDTLS_SSL_PROTO_TLS1_3)
+#if defined(MBEDTLS_CHACHAPOLY_C)
+  MBEDTLS_TLS1_3_CHACHA20_POLY1305_SHA256,
+#endif
+#if defined(MBEDTLS_GCM_C)
+  MBEDTLS_TLS1_3_AES_128_GCM_SHA256,
+#if defined(MBEDTLS_SHA384_C)
+  MBEDTLS_TLS1_3_AES_256_GCM_SHA384,
+#endif
+#endif
+#endif
+#if defined(MBEDTLS_SSL_PROTO_TLS1_2)
+#if defined(MBEDTLS_CHACHAPOLY_C)
+#if defined(MBEDTLS_KEY_EXCHANGE_ECDHE_ECDSA_ENABLED)
+  MBEDTLS_TLS_ECDHE_ECDSA_WITH_CHACHA20_POLY1305_SHA256,
+#endif
+#if defined(MBEDTLS_KEY_EXCHANGE_ECDHE_RSA_ENABLED)
+  MBEDTLS_TLS_ECDHE_RSA_WITH_CHACHA20_POLY1305_SHA256,
+#endif
+#endif
+#if defined(MBEDTLS_GCM_C)
+#if defined(MBEDTLS_KEY_EXCHANGE_ECDHE_ECDSA_ENABLED)
+  MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_128_GCM_SHA256,
+#endif
+#if defined(MBEDTLS_KEY_EXCHANGE_ECDHE_RSA_ENABLED)
+  MBEDTLS_TLS_ECDHE_RSA_WITH_AES_128_GCM_SHA256,
+#endif
+#if defined(MBEDTLS_SHA384_C)
+#if defined(MBEDTLS_KEY_EXCHANGE_ECDHE_ECDSA_ENABLED)
+  MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_256_GCM_SHA384,
+#endif
+#if defined(MBEDTLS_KEY_EXCHANGE_ECDHE_RSA_ENABLED)
+  MBEDTLS_TLS_ECDHE_RSA_WITH_AES_256_GCM_SHA384,
+#endif
+#endif
+#endif
+#endif
+  0
+};
+
+// X25519 costs a fraction of the generic curve arithmetic, P-256 is what nearly every
+// server accepts and P-384 is kept for the rest
+static const uint16_t DEFAULT_GROUPS[] = {
+#if defined(MBEDTLS_ECP_DP_CURVE25519_ENABLED)
+  MBEDTLS_SSL_IANA_TLS_GROUP_X25519,
+#endif
+#if defined(MBEDTLS_ECP_DP_SECP256R1_ENABLED)
+  MBEDTLS_SSL_IANA_TLS_GROUP_SECP256R1,
+#endif
+#if defined(MBEDTLS_ECP_DP_SECP384R1_ENABLED)
+  MBEDTLS_SSL_IANA_TLS_GROUP_SECP384R1,
+#endif
+  MBEDTLS_SSL_IANA_TLS_GROUP_NONE
+};
+
+// GitHub serves ECDSA P-256 certificates under RSA and ECDSA CAs
+static const struct
+{
+  const char* name;
+  uint16_t id;
+} SIGNATURE_ALGORITHMS[] = {
+#if defined(MBEDTLS_ECDSA_C) && defined(MBEDTLS_ECP_DP_SECP256R1_ENABLED)
+  { "ecdsa_secp256r1_sha256", MBEDTLS_TLS1_3_SIG_ECDSA_SECP256R1_SHA256 },
+#endif
+#if defined(MBEDTLS_RSA_C) && defined(MBEDTLS_PKCS1_V21)
+  { "rsa_pss_rsae_sha256", MBEDTLS_TLS1_3_SIG_RSA_PSS_RSAE_SHA256 },
+#endif
+#if defined(MBEDTLS_RSA_C) && defined(MBEDTLS_PKCS1_V15)
+  { "rsa_pkcs1_sha256", MBEDTLS_TLS1_3_SIG_RSA_PKCS1_SHA256 },
+#endif
+#if defined(MBEDTLS_SHA384_C)
+#if defined(MBEDTLS_ECDSA_C) && defined(MBEDTLS_ECP_DP_SECP384R1_ENABLED)
+  { "ecdsa_secp384r1_sha384", MBEDTLS_TLS1_3_SIG_ECDSA_SECP384R1_SHA384 },
+#endif
+#if defined(MBEDTLS_RSA_C) && defined(MBEDTLS_PKCS1_V21)
+  { "rsa_pss_rsae_sha384", MBEDTLS_TLS1_3_SIG_RSA_PSS_RSAE_SHA384 },
+#endif
+#if defined(MBEDTLS_RSA_C) && defined(MBEDTLS_PKCS1_V15)
+  { "rsa_pkcs1_sha384", MBEDTLS_TLS1_3_SIG_RSA_PKCS1_SHA384 },
+#endif
+#endif
+#if defined(MBEDTLS_SHA512_C)
+#if defined(MBEDTLS_RSA_C) && defined(MBEDTLS_PKCS1_V21)
+  { "rsa_pss_rsae_sha512", MBEDTLS_TLS1_3_SIG_RSA_PSS_RSAE_SHA512 },
+#endif
+#if defined(MBEDTLS_RSA_C) && defined(MBEDTLS_PKCS1_V15)
+  { "rsa_pkcs1_sha512", MBEDTLS_TLS1_3_SIG_RSA_PKCS1_SHA512 },
+#endif
+#endif
+};
+
+static std::vector<uint16_t> DefaultSignatureAlgorithms()
+{
+  std::vector<uint16_t> algorithms;
+  for (const auto& algorithm : SIGNATURE_ALGORITHMS)
+    algorithms.push_back(algorithm.id);
+  algorithms.push_back(MBEDTLS_TLS1_3_SIG_NONE);
+  return algorithms;
+}
+
+std::weak_ptr<CTLSContext> CTLSContext::m_instance;
+CCriticalSection CTLSContext::m_critSection;
+unsigned int CTLSContext::m_maxFragmentLength = 0;
+std::vector<uint16_t> CTLSContext::m_groups(DEFAULT_GROUPS, DEFAULT_GROUPS + sizeof(DEFAULT_GROUPS) / sizeof(DEFAULT_GROUPS[0]));
+std::vector<uint16_t> CTLSContext::m_signatureAlgorithms = DefaultSignatureAlgorithms();
+
+static void mbedtls_debug(void *ctx, int level, const char *file, int line, const char *str)
+{
+  (void)ctx;
+  (void)level;
+  printf("%s:%d: %s\n", file, line, str);
+}
+
+CTLSContext::CTLSContext()
+{
+  mbedtls_entropy_init(&m_entropy);
+  mbedtls_ctr_drbg_init(&m_ctrDrbg);
+  mbedtls_x509_crt_init(&m_cacert);
+  mbedtls_ssl_config_init(&m_conf);
+  mbedtls_ssl_config_init(&m_pinnedConf);
+}
+
+CTLSContext::~CTLSContext()
+{
+  mbedtls_ssl_config_free(&m_pinnedConf);
+  mbedtls_ssl_config_free(&m_conf);
+  mbedtls_x509_crt_free(&m_cacert);
+  mbedtls_ctr_drbg_free(&m_ctrDrbg);
+  mbedtls_entropy_free(&m_entropy);
+}
+
+std::shared_ptr<CTLSContext> CTLSContext::Get()
+{
+  CSingleLock lock(m_critSection);
+
+  // downloads run on several threads, so mbedtls needs its mutexes before the first context exists
+  mbedtls_threading_setup();
+
+  std::shared_ptr<CTLSContext> context = m_instance.lock();
+  if (context)
+    return context;
+
+  CStopWatch watch;
+  watch.StartZero();
+
+  context = std::shared_ptr<CTLSContext>(new CTLSContext());
+  if (!context->Initialize())
+  {
+    printf("TLS context setup failed\n");
+    return context;
+  }
+
+  printf("TLS context setup took %.2f ms\n", watch.GetElapsedMilliseconds());
+  m_instance = context;
+  return context;
+}
+
+const int* CTLSContext::GetCiphersuites()
+{
+  return CIPHERSUITES;
+}
+
+bool CTLSContext::SetGroups(const std::string& strGroups)
+{
+  std::vector<uint16_t> groups;
+  for (const std::string& strName : StringUtils::Split(strGroups, ","))
+  {
+    const mbedtls_ecp_curve_info* info = mbedtls_ecp_curve_info_from_name(strName.c_str());
+    if (!info)
+      return false;
+    groups.push_back(info->tls_id);
+  }
+
+  if (groups.empty())
+    return false;
+
+  groups.push_back(MBEDTLS_SSL_IANA_TLS_GROUP_NONE);
+  CSingleLock lock(m_critSection);
+  m_groups = std::move(groups);
+  return true;
+}
+
+bool CTLSContext::SetSignatureAlgorithms(const std::string& strAlgorithms)
+{
+  std::vector<uint16_t> algorithms;
+  for (const std::string& strName : StringUtils::Split(strAlgorithms, ","))
+  {
+    auto it = std::find_if(std::begin(SIGNATURE_ALGORITHMS), std::end(SIGNATURE_ALGORITHMS), [&strName](const auto& algorithm) {
+      return StringUtils::EqualsNoCase(strName, algorithm.name);
+    });
+    if (it == std::end(SIGNATURE_ALGORITHMS))
+      return false;
+    algorithms.push_back(it->id);
+  }
+
+  if (algorithms.empty())
+    return false;
+
+  algorithms.push_back(MBEDTLS_TLS1_3_SIG_NONE);
+  CSingleLock lock(m_critSection);
+  m_signatureAlgorithms = std::move(algorithms);
+  return true;
+}
+
+bool CTLSContext::Initialize()
+{
+  if (psa_crypto_init() != PSA_SUCCESS)
+    return false;
+
+  if (mbedtls_ctr_drbg_seed(&m_ctrDrbg, mbedtls_entropy_func, &m_entropy, NULL, 0) != 0)
+    return false;
+
+#if defined(UPDATER_DER_TRUST_STORE)
+  if (!LoadTrustStore())
+    return false;
+#else
+  // a positive result counts certificates using algorithms left out of the build, the rest loaded fine
+  if (mbedtls_x509_crt_parse(&m_cacert, cert, sizeof(cert)) < 0)
+    return false;
+#endif
+
+#if defined(MBEDTLS_DEBUG_C)
+  mbedtls_debug_set_threshold(0);
+#endif
+  // Get() holds the lock, the setters can't change the lists meanwhile
+  m_offeredGroups = m_groups;
+  m_offeredSignatureAlgorithms = m_signatureAlgorithms;
+
+  // the server's signature over the handshake is checked either way, the pinned
+  // config only leaves out the chain, CHTTPConnection compares the certificate
+  // against CCertificateCache instead
+  if (!SetupConfig(&m_conf, MBEDTLS_SSL_VERIFY_REQUIRED) ||
+      !SetupConfig(&m_pinnedConf, MBEDTLS_SSL_VERIFY_NONE))
+    return false;
+
+  m_initialized = true;
+  return true;
+}
+
+bool CTLSContext::SetupConfig(mbedtls_ssl_config* conf, int authmode)
+{
+  if (mbedtls_ssl_config_defaults(conf, MBEDTLS_SSL_IS_CLIENT, MBEDTLS_SSL_TRANSPORT_STREAM, MBEDTLS_SSL_PRESET_DEFAULT) != 0)
+    return false;
+
+  mbedtls_ssl_conf_authmode(conf, authmode);
+  mbedtls_ssl_conf_rng(conf, mbedtls_ctr_drbg_random, &m_ctrDrbg);
+#if defined(UPDATER_DER_TRUST_STORE)
+  mbedtls_ssl_conf_ca_cb(conf, FindTrustedCA, this);
+#else
+  mbedtls_ssl_conf_ca_chain(conf, &m_cacert, NULL);
+#endif
+  mbedtls_ssl_conf_dbg(conf, mbedtls_debug, stdout);
+  mbedtls_ssl_conf_ciphersuites(conf, CIPHERSUITES);
+  mbedtls_ssl_conf_groups(conf, m_offeredGroups.data());
+  mbedtls_ssl_conf_sig_algs(conf, m_offeredSignatureAlgorithms.data());
+#if defined(MBEDTLS_SSL_MAX_FRAGMENT_LENGTH)
+  unsigned char mfl = MBEDTLS_SSL_MAX_FRAG_LEN_NONE;
+  switch (m_maxFragmentLength)
+  {
+  case 512: mfl = MBEDTLS_SSL_MAX_FRAG_LEN_512; break;
+  case 1024: mfl = MBEDTLS_SSL_MAX_FRAG_LEN_1024; break;
+  case 2048: mfl = MBEDTLS_SSL_MAX_FRAG_LEN_2048; break;
+  case 4096: mfl = MBEDTLS_SSL_MAX_FRAG_LEN_4096; break;
+  }
+  // only TLS 1.2 servers that implement the extension honour this
+  if (mfl != MBEDTLS_SSL_MAX_FRAG_LEN_NONE)
+    mbedtls_ssl_conf_max_frag_len(conf, mfl);
+#endif
+#if defined(MBEDTLS_SSL_PROTO_TLS1_3) && defined(MBEDTLS_SSL_SESSION_TICKETS)
+  // let CHTTPConnection see TLS 1.3 tickets so they can be cached for resumption
+  mbedtls_ssl_conf_tls13_enable_signal_new_session_tickets(conf, MBEDTLS_SSL_TLS1_3_SIGNAL_NEW_SESSION_TICKETS_ENABLED);
+#endif
+
+  return true;
+}
+
+#if defined(UPDATER_DER_TRUST_STORE)
+bool CTLSContext::LoadTrustStore()
+{
+  if (sizeof(truststore) < TRUST_STORE_HEADER_SIZE || memcmp(truststore, "XCAS", 4) != 0)
+    return false;
+
+  uint32_t version, count;
+  memcpy(&version, truststore + 4, sizeof(version));
+  memcpy(&count, truststore + 8, sizeof(count));
+  if (version != TRUST_STORE_VERSION || count > (sizeof(truststore) - TRUST_STORE_HEADER_SIZE) / sizeof(TrustStoreEntry))
+    return false;
+
+  const TrustStoreEntry *entries = reinterpret_cast<const TrustStoreEntry *>(truststore + TRUST_STORE_HEADER_SIZE);
+  for (uint32_t i = 0; i < count; ++i)
+  {
+    if (entries[i].offset > sizeof(truststore) || entries[i].length > sizeof(truststore) - entries[i].offset)
+      return false;
+  }
+
+  m_trustStore = entries;
+  m_trustStoreCount = count;
+  return true;
+}
+
+int CTLSContext::FindTrustedCA(void *ctx, mbedtls_x509_crt const *child, mbedtls_x509_crt **candidates)
+{
+  const CTLSContext *context = static_cast<const CTLSContext *>(ctx);
+  *candidates = NULL;
+
+  const uint32_t hash = SubjectHash(child->issuer_raw.p, child->issuer_raw.len);
+  const TrustStoreEntry *first = context->m_trustStore;
+  const TrustStoreEntry *last = first + context->m_trustStoreCount;
+  const TrustStoreEntry *it = std::lower_bound(first, last, hash, [](const TrustStoreEntry& entry, uint32_t value) {
+    return entry.hash < value;
+  });
+
+  mbedtls_x509_crt *chain = NULL;
+  for (; it != last && it->hash == hash; ++it)
+  {
+    if (!chain)
+    {
+      // ownership passes to mbedtls, which releases it with mbedtls_free()
+      chain = static_cast<mbedtls_x509_crt *>(mbedtls_calloc(1, sizeof(mbedtls_x509_crt)));
+      if (!chain)
+        return MBEDTLS_ERR_X509_ALLOC_FAILED;
+      mbedtls_x509_crt_init(chain);
+    }
+
+    // the store is static, so the parsed certificate can point straight into it
+    mbedtls_x509_crt_parse_der_nocopy(chain, truststore + it->offset, it->length);
+  }
+
+  if (chain && chain->raw.p == NULL)
+  {
+    mbedtls_x509_crt_free(chain);
+    mbedtls_free(chain);
+    chain = NULL;
+  }
+
+  *candidates = chain;
+  return 0;
+}
+#endif
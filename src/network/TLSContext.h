@@ -0,0 +1,120 @@
+/*
+ *  Copyright (C) 2025-2025
+ *  This file is part of XBMC - https://github.com/antonic901/xbmc4xbox-redux
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+#include "threads/CriticalSection.h"
+
+#include <memory>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include <mbedtls/ctr_drbg.h>
+#include <mbedtls/entropy.h>
+#include <mbedtls/ssl.h>
+#include <mbedtls/x509_crt.h>
+
+#if defined(UPDATER_DER_TRUST_STORE)
+struct TrustStoreEntry;
+#endif
+
+/*!
+  \brief Process wide TLS client state shared by every CDownloader.
+
+  Seeding the DRBG and loading the trust anchors is by far the most expensive
+  part of setting up a connection, so it is done once when the first reference
+  is taken and released again when the last holder goes away.
+
+  When built with UPDATER_DER_TRUST_STORE the CA bundle is a precompiled DER
+  blob indexed by subject hash and only the issuer a handshake actually asks
+  for is parsed, through the mbedtls CA callback.
+
+  The context is shared between threads. mbedtls is built with
+  MBEDTLS_THREADING_ALT, which keeps the DRBG and the PSA key store consistent.
+*/
+class CTLSContext
+{
+public:
+  ~CTLSContext();
+
+  static std::shared_ptr<CTLSContext> Get();
+
+  /*!
+    \brief Asks servers for smaller TLS records (RFC 6066 max_fragment_length).
+    Takes effect for contexts created afterwards, 0 keeps the default 16 KB records.
+    \param length 512, 1024, 2048 or 4096
+  */
+  static void SetMaxFragmentLength(unsigned int length) { m_maxFragmentLength = length; }
+
+  /*!
+    \brief Ciphersuites offered to servers, most preferred first, terminated by 0.
+  */
+  static const int* GetCiphersuites();
+
+  /*!
+    \brief Replaces the key exchange groups offered to servers, most preferred first.
+    Takes effect for contexts created afterwards.
+    \param strGroups comma separated curve names, e.g. "x25519,secp256r1"
+    \return false if a name is unknown or not built in, the list is left unchanged then
+  */
+  static bool SetGroups(const std::string& strGroups);
+
+  /*!
+    \brief Replaces the signature algorithms offered to servers, most preferred first.
+    Takes effect for contexts created afterwards.
+    \param strAlgorithms comma separated TLS 1.3 names, e.g. "ecdsa_secp256r1_sha256,rsa_pss_rsae_sha256"
+    \return false if a name is unknown, the list is left unchanged then
+  */
+  static bool SetSignatureAlgorithms(const std::string& strAlgorithms);
+
+  bool IsValid() const { return m_initialized; }
+  const mbedtls_ssl_config* GetConfig() const { return &m_conf; }
+
+  /*!
+    \brief Same as GetConfig() but without verifying the server's certificate chain,
+    for hosts whose certificate is in CCertificateCache. The caller must check the
+    certificate against the cache once the handshake is done.
+  */
+  const mbedtls_ssl_config* GetPinnedConfig() const { return &m_pinnedConf; }
+
+private:
+  CTLSContext();
+  CTLSContext(const CTLSContext&) = delete;
+  CTLSContext& operator=(const CTLSContext&) = delete;
+
+  bool Initialize();
+  bool SetupConfig(mbedtls_ssl_config* conf, int authmode);
+
+#if defined(UPDATER_DER_TRUST_STORE)
+  bool LoadTrustStore();
+  static int FindTrustedCA(void *ctx, mbedtls_x509_crt const *child, mbedtls_x509_crt **candidates);
+
+  const TrustStoreEntry *m_trustStore = nullptr;
+  size_t m_trustStoreCount = 0;
+#endif
+
+  mbedtls_entropy_context m_entropy;
+  mbedtls_ctr_drbg_context m_ctrDrbg;
+  mbedtls_ssl_config m_conf;
+  mbedtls_ssl_config m_pinnedConf;
+  mbedtls_x509_crt m_cacert;
+
+  // copies of the lists above, both configs point into them
+  std::vector<uint16_t> m_offeredGroups;
+  std::vector<uint16_t> m_offeredSignatureAlgorithms;
+
+  bool m_initialized = false;
+
+  static std::weak_ptr<CTLSContext> m_instance;
+  static CCriticalSection m_critSection;
+  static unsigned int m_maxFragmentLength;
+  // terminated by MBEDTLS_SSL_IANA_TLS_GROUP_NONE and MBEDTLS_TLS1_3_SIG_NONE
+  static std::vector<uint16_t> m_groups;
+  static std::vector<uint16_t> m_signatureAlgorithms;
+};
@@ -0,0 +1,176 @@
+/*
+ *  Copyright (C) 2025-2025
+ *  This file is part of XBMC - https://github.com/antonic901/xbmc4xbox-redux
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#include "TLSSessionCache.h"
+
+#include "threads/SingleLock.h"
+
+#include <ctype.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+static const char SESSION_FILE_MAGIC[4] = { 'X', 'T', 'S', 'C' };
+static const uint32_t SESSION_FILE_VERSION = 1;
+// sessions carry the peer certificate, anything much bigger than that is garbage
+static const uint32_t MAX_SESSION_SIZE = 16 * 1024;
+static const uint32_t MAX_HOST_SIZE = 255;
+
+std::map<std::string, std::vector<unsigned char>> CTLSSessionCache::m_sessions;
+unsigned int CTLSSessionCache::m_resumedHandshakes = 0;
+unsigned int CTLSSessionCache::m_fullHandshakes = 0;
+CCriticalSection CTLSSessionCache::m_critSection;
+
+static std::string MakeKey(const std::string& strHost)
+{
+  std::string strKey(strHost);
+  for (char& c : strKey)
+    c = ::tolower(c);
+  return strKey;
+}
+
+// the current session of the connection in the form mbedtls_ssl_session_load() takes
+static bool SaveSession(const mbedtls_ssl_context* ssl, std::vector<unsigned char>& data)
+{
+  mbedtls_ssl_session session;
+  mbedtls_ssl_session_init(&session);
+  bool bResult = false;
+  if (mbedtls_ssl_get_session(ssl, &session) == 0)
+  {
+    size_t size = 0;
+    mbedtls_ssl_session_save(&session, NULL, 0, &size);
+    if (size > 0 && size <= MAX_SESSION_SIZE)
+    {
+      data.resize(size);
+      bResult = mbedtls_ssl_session_save(&session, data.data(), data.size(), &size) == 0;
+    }
+  }
+  mbedtls_ssl_session_free(&session);
+  return bResult;
+}
+
+bool CTLSSessionCache::Restore(const std::string& strHost, mbedtls_ssl_context* ssl, std::vector<unsigned char>& offered)
+{
+  CSingleLock lock(m_critSection);
+  auto it = m_sessions.find(MakeKey(strHost));
+  if (it == m_sessions.end())
+    return false;
+
+  mbedtls_ssl_session session;
+  mbedtls_ssl_session_init(&session);
+  bool bRestored = mbedtls_ssl_session_load(&session, it->second.data(), it->second.size()) == 0 &&
+                   mbedtls_ssl_set_session(ssl, &session) == 0;
+  mbedtls_ssl_session_free(&session);
+
+  // a session this build of mbedtls can't load is never going to work
+  if (!bRestored)
+    m_sessions.erase(it);
+  else
+    offered = it->second;
+
+  return bRestored;
+}
+
+void CTLSSessionCache::Store(const std::string& strHost, const mbedtls_ssl_context* ssl)
+{
+  std::vector<unsigned char> data;
+  if (SaveSession(ssl, data))
+  {
+    CSingleLock lock(m_critSection);
+    m_sessions[MakeKey(strHost)] = std::move(data);
+  }
+}
+
+bool CTLSSessionCache::IsResumed(const mbedtls_ssl_context* ssl, const std::vector<unsigned char>& offered)
+{
+  // a TLS 1.2 ticket resumption gets a fresh session id from the client, it counts as full
+  std::vector<unsigned char> data;
+  return !offered.empty() && SaveSession(ssl, data) && data == offered;
+}
+
+void CTLSSessionCache::OnHandshake(bool bResumed)
+{
+  CSingleLock lock(m_critSection);
+  if (bResumed)
+    m_resumedHandshakes++;
+  else
+    m_fullHandshakes++;
+}
+
+bool CTLSSessionCache::Load(const std::string& strPath)
+{
+  FILE* file = fopen(strPath.c_str(), "rb");
+  if (!file)
+    return false;
+
+  CSingleLock lock(m_critSection);
+
+  char magic[4];
+  uint32_t version = 0, count = 0;
+  bool bResult = fread(magic, sizeof(magic), 1, file) == 1 && memcmp(magic, SESSION_FILE_MAGIC, sizeof(magic)) == 0 &&
+                 fread(&version, sizeof(version), 1, file) == 1 && version == SESSION_FILE_VERSION &&
+                 fread(&count, sizeof(count), 1, file) == 1;
+
+  for (uint32_t i = 0; bResult && i < count; ++i)
+  {
+    uint32_t hostSize = 0, dataSize = 0;
+    if (fread(&hostSize, sizeof(hostSize), 1, file) != 1 || hostSize == 0 || hostSize > MAX_HOST_SIZE)
+    {
+      bResult = false;
+      break;
+    }
+
+    std::string strHost(hostSize, '\0');
+    if (fread(&strHost[0], hostSize, 1, file) != 1 ||
+        fread(&dataSize, sizeof(dataSize), 1, file) != 1 || dataSize == 0 || dataSize > MAX_SESSION_SIZE)
+    {
+      bResult = false;
+      break;
+    }
+
+    std::vector<unsigned char> data(dataSize);
+    if (fread(data.data(), dataSize, 1, file) != 1)
+    {
+      bResult = false;
+      break;
+    }
+
+    // sessions negotiated during this run are newer than the ones on disk
+    m_sessions.emplace(MakeKey(strHost), std::move(data));
+  }
+
+  fclose(file);
+  return bResult;
+}
+
+bool CTLSSessionCache::Save(const std::string& strPath)
+{
+  FILE* file = fopen(strPath.c_str(), "wb");
+  if (!file)
+    return false;
+
+  CSingleLock lock(m_critSection);
+
+  const uint32_t count = m_sessions.size();
+  bool bResult = fwrite(SESSION_FILE_MAGIC, sizeof(SESSION_FILE_MAGIC), 1, file) == 1 &&
+                 fwrite(&SESSION_FILE_VERSION, sizeof(SESSION_FILE_VERSION), 1, file) == 1 &&
+                 fwrite(&count, sizeof(count), 1, file) == 1;
+
+  for (auto it = m_sessions.begin(); bResult && it != m_sessions.end(); ++it)
+  {
+    const uint32_t hostSize = it->first.size();
+    const uint32_t dataSize = it->second.size();
+    bResult = fwrite(&hostSize, sizeof(hostSize), 1, file) == 1 &&
+              fwrite(it->first.data(), hostSize, 1, file) == 1 &&
+              fwrite(&dataSize, sizeof(dataSize), 1, file) == 1 &&
+              fwrite(it->second.data(), dataSize, 1, file) == 1;
+  }
+
+  fclose(file);
+  return bResult;
+}
@@ -0,0 +1,56 @@
+/*
+ *  Copyright (C) 2025-2025
+ *  This file is part of XBMC - https://github.com/antonic901/xbmc4xbox-redux
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+#include "threads/CriticalSection.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <mbedtls/ssl.h>
+
+/*!
+  \brief Remembers the last TLS session negotiated with every host so later
+  connections, including ones made by the next run of the updater, can resume
+  it instead of doing a full handshake.
+*/
+class CTLSSessionCache
+{
+public:
+  CTLSSessionCache() = delete;
+
+  /*!
+    \brief Offers the cached session for the host on a connection that is about to handshake.
+    \param offered receives the session that was offered, for IsResumed()
+    \return true if a session was offered
+  */
+  static bool Restore(const std::string& strHost, mbedtls_ssl_context* ssl, std::vector<unsigned char>& offered);
+  static void Store(const std::string& strHost, const mbedtls_ssl_context* ssl);
+
+  /*!
+    \brief Whether a finished handshake resumed the offered session. A full handshake
+    negotiates new secrets, so its session never matches the one offered. Call it before
+    any application data is read, a TLS 1.3 ticket arriving later changes the session.
+  */
+  static bool IsResumed(const mbedtls_ssl_context* ssl, const std::vector<unsigned char>& offered);
+
+  static bool Load(const std::string& strPath);
+  static bool Save(const std::string& strPath);
+
+  static void OnHandshake(bool bResumed);
+  static unsigned int GetResumedHandshakes() { return m_resumedHandshakes; }
+  static unsigned int GetFullHandshakes() { return m_fullHandshakes; }
+
+private:
+  static std::map<std::string, std::vector<unsigned char>> m_sessions;
+  static unsigned int m_resumedHandshakes;
+  static unsigned int m_fullHandshakes;
+  static CCriticalSection m_critSection;
+};
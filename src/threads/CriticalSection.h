@@ -0,0 +1,30 @@
+/*
+ *  Copyright (C) 2025-2025
+ *  This file is part of XBMC - https://github.com/antonic901/xbmc4xbox-redux
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+#include <windows.h>
+
+/*!
+  \brief Recursive lock around a Win32 CRITICAL_SECTION.
+*/
+class CCriticalSection
+{
+public:
+  CCriticalSection() { InitializeCriticalSection(&m_cs); }
+  ~CCriticalSection() { DeleteCriticalSection(&m_cs); }
+
+  void lock() { EnterCriticalSection(&m_cs); }
+  void unlock() { LeaveCriticalSection(&m_cs); }
+
+private:
+  CCriticalSection(const CCriticalSection&) = delete;
+  CCriticalSection& operator=(const CCriticalSection&) = delete;
+
+  CRITICAL_SECTION m_cs;
+};
@@ -0,0 +1,27 @@
+/*
+ *  Copyright (C) 2025-2025
+ *  This file is part of XBMC - https://github.com/antonic901/xbmc4xbox-redux
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+#include "threads/CriticalSection.h"
+
+/*!
+  \brief Holds a CCriticalSection for the lifetime of the object.
+*/
+class CSingleLock
+{
+public:
+  explicit CSingleLock(CCriticalSection& cs) : m_cs(cs) { m_cs.lock(); }
+  ~CSingleLock() { m_cs.unlock(); }
+
+private:
+  CSingleLock(const CSingleLock&) = delete;
+  CSingleLock& operator=(const CSingleLock&) = delete;
+
+  CCriticalSection& m_cs;
+};
@@ -10,9 +10,48 @@
 
 #include "utils/StringUtils.h"
 
+#include <algorithm>
+#include <stdlib.h>
 #include <vector>
 #include <hal/xbox.h>
 
+// a timeout of 0 would fail every wait, anything past a few minutes looks like a typo
+static const unsigned long MIN_TIMEOUT = 1000;
+static const unsigned long MAX_TIMEOUT = 5 * 60 * 1000;
+
+// leaves number untouched unless the whole value is a decimal number
+static bool ParseNumber(const std::string& value, unsigned long& number)
+{
+  if (value.empty() || value[0] < '0' || value[0] > '9')
+    return false;
+
+  char* end = NULL;
+  const unsigned long parsed = strtoul(value.c_str(), &end, 10);
+  if (*end != '\0')
+    return false;
+
+  number = parsed;
+  return true;
+}
+
+// in milliseconds, 0 and values that don't parse keep the default
+static void ParseTimeout(const std::string& value, unsigned long& timeout)
+{
+  unsigned long parsed = 0;
+  if (ParseNumber(value, parsed) && parsed > 0)
+    timeout = std::min(std::max(parsed, MIN_TIMEOUT), MAX_TIMEOUT);
+}
+
+static bool ParseNumber(const std::string& value, unsigned int& number)
+{
+  unsigned long parsed = 0;
+  if (!ParseNumber(value, parsed))
+    return false;
+
+  number = static_cast<unsigned int>(parsed);
+  return true;
+}
+
 void CCustomLaunch::Set(const std::string& key, const std::string& value)
 {
   if (key == "version")
@@ -27,6 +66,62 @@ void CCustomLaunch::Set(const std::string& key, const std::string& value)
   {
     m_updateChannel = value;
   }
+  else if (key == "segments")
+  {
+    ParseNumber(value, m_downloadSegments);
+  }
+  else if (key == "readsize")
+  {
+    ParseNumber(value, m_readSize);
+  }
+  else if (key == "maxfrag")
+  {
+    ParseNumber(value, m_maxFragmentLength);
+  }
+  else if (key == "connecttimeout")
+  {
+    ParseTimeout(value, m_connectTimeout);
+  }
+  else if (key == "firstbytetimeout")
+  {
+    ParseTimeout(value, m_firstByteTimeout);
+  }
+  else if (key == "idletimeout")
+  {
+    ParseTimeout(value, m_idleTimeout);
+  }
+  else if (key == "timings")
+  {
+    m_bRequestTimings = value == "1" || StringUtils::EqualsNoCase(value, "true");
+  }
+  else if (key == "groups")
+  {
+    m_groups = value;
+  }
+  else if (key == "sigalgs")
+  {
+    m_signatureAlgorithms = value;
+  }
+  else if (key == "stream")
+  {
+    m_bStreamExtract = value == "1" || StringUtils::EqualsNoCase(value, "true");
+  }
+  else if (key == "checkpoint")
+  {
+    m_bCheckpoint = value == "1" || StringUtils::EqualsNoCase(value, "true");
+  }
+  else if (key == "extractbuffer")
+  {
+    ParseNumber(value, m_extractBufferSize);
+  }
+  else if (key == "preallocate")
+  {
+    m_bPreallocate = value == "1" || StringUtils::EqualsNoCase(value, "true");
+  }
+  else if (key == "extractwriters")
+  {
+    ParseNumber(value, m_extractWriters);
+  }
 }
 
 bool CCustomLaunch::Read()
@@ -34,6 +34,20 @@ public:
   std::string GetVersion() const { return m_version; }
   std::string GetRevision() const { return m_revision; }
   std::string GetUpdateChannel() const { return m_updateChannel; }
+  unsigned int GetDownloadSegments() const { return m_downloadSegments; }
+  unsigned int GetReadSize() const { return m_readSize; }
+  unsigned int GetMaxFragmentLength() const { return m_maxFragmentLength; }
+  unsigned long GetConnectTimeout() const { return m_connectTimeout; }
+  unsigned long GetFirstByteTimeout() const { return m_firstByteTimeout; }
+  unsigned long GetIdleTimeout() const { return m_idleTimeout; }
+  bool GetRequestTimings() const { return m_bRequestTimings; }
+  std::string GetGroups() const { return m_groups; }
+  std::string GetSignatureAlgorithms() const { return m_signatureAlgorithms; }
+  bool GetStreamExtract() const { return m_bStreamExtract; }
+  bool GetCheckpoint() const { return m_bCheckpoint; }
+  unsigned int GetExtractBufferSize() const { return m_extractBufferSize; }
+  bool GetPreallocate() const { return m_bPreallocate; }
+  unsigned int GetExtractWriters() const { return m_extractWriters; }
 
 private:
   void Set(const std::string& key, const std::string& value);
@@ -41,4 +55,18 @@ private:
   std::string m_version;
   std::string m_revision;
   std::string m_updateChannel;
+  unsigned int m_downloadSegments = 1;
+  unsigned int m_readSize = 0;
+  unsigned int m_maxFragmentLength = 0;
+  unsigned long m_connectTimeout = 10 * 1000;
+  unsigned long m_firstByteTimeout = 30 * 1000;
+  unsigned long m_idleTimeout = 30 * 1000;
+  bool m_bRequestTimings = false;
+  std::string m_groups;
+  std::string m_signatureAlgorithms;
+  bool m_bStreamExtract = false;
+  bool m_bCheckpoint = true;
+  unsigned int m_extractBufferSize = 0;
+  bool m_bPreallocate = true;
+  unsigned int m_extractWriters = 0;
 };
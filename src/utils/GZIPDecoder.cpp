@@ -0,0 +1,73 @@
+/*
+ *  Copyright (C) 2025-2025
+ *  This file is part of XBMC - https://github.com/antonic901/xbmc4xbox-redux
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#include "GZIPDecoder.h"
+
+#include <zlib.h>
+
+static const size_t OUTPUT_BUFFER_SIZE = 16 * 1024;
+// 15 bits is the largest window deflate uses, 16 selects gzip instead of zlib framing
+static const int WINDOW_BITS = 15 + 16;
+
+CGZIPDecoder::CGZIPDecoder() : m_stream(new z_stream()), m_buffer(OUTPUT_BUFFER_SIZE)
+{
+}
+
+CGZIPDecoder::~CGZIPDecoder()
+{
+  if (m_initialized)
+    inflateEnd(m_stream.get());
+}
+
+bool CGZIPDecoder::Decode(const char* data, size_t size, const OutputCallback& onOutput)
+{
+  if (!m_initialized)
+  {
+    if (inflateInit2(m_stream.get(), WINDOW_BITS) != Z_OK)
+      return false;
+    m_initialized = true;
+  }
+
+  // anything after the end of the member is ignored
+  if (m_finished)
+    return true;
+
+  m_stream->next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data));
+  m_stream->avail_in = size;
+  do
+  {
+    m_stream->next_out = reinterpret_cast<Bytef*>(m_buffer.data());
+    m_stream->avail_out = m_buffer.size();
+
+    int ret = inflate(m_stream.get(), Z_NO_FLUSH);
+    if (ret == Z_STREAM_END)
+      m_finished = true;
+    else if (ret != Z_OK && ret != Z_BUF_ERROR)
+      return false;
+
+    const size_t produced = m_buffer.size() - m_stream->avail_out;
+    if (produced > 0 && !onOutput(m_buffer.data(), produced))
+      return false;
+
+    // no progress possible until more input arrives
+    if (ret == Z_BUF_ERROR)
+      break;
+  } while (!m_finished && (m_stream->avail_in > 0 || m_stream->avail_out == 0));
+
+  return true;
+}
+
+unsigned long CGZIPDecoder::GetInputSize() const
+{
+  return m_stream->total_in;
+}
+
+unsigned long CGZIPDecoder::GetOutputSize() const
+{
+  return m_stream->total_out;
+}
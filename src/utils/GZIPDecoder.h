@@ -0,0 +1,53 @@
+/*
+ *  Copyright (C) 2025-2025
+ *  This file is part of XBMC - https://github.com/antonic901/xbmc4xbox-redux
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+struct z_stream_s;
+
+/*!
+  \brief Inflates a gzip stream as it arrives.
+
+  Memory use is fixed: zlib's 32 KB window and its state, plus one output
+  buffer that is handed to the callback each time it fills up.
+*/
+class CGZIPDecoder
+{
+public:
+  typedef std::function<bool(const char* data, size_t size)> OutputCallback;
+
+  CGZIPDecoder();
+  ~CGZIPDecoder();
+
+  /*!
+    \brief Feeds the next part of the compressed stream.
+    \return false on corrupt input or if the callback refused the output
+  */
+  bool Decode(const char* data, size_t size, const OutputCallback& onOutput);
+
+  /*!
+    \brief True once the whole gzip member, including its checksum, was decoded.
+  */
+  bool IsFinished() const { return m_finished; }
+
+  unsigned long GetInputSize() const;
+  unsigned long GetOutputSize() const;
+
+private:
+  CGZIPDecoder(const CGZIPDecoder&) = delete;
+  CGZIPDecoder& operator=(const CGZIPDecoder&) = delete;
+
+  std::unique_ptr<z_stream_s> m_stream;
+  std::vector<char> m_buffer;
+  bool m_initialized = false;
+  bool m_finished = false;
+};
@@ -0,0 +1,104 @@
+/*
+ *  Copyright (C) 2025-2025
+ *  This file is part of XBMC - https://github.com/antonic901/xbmc4xbox-redux
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#include "StreamBuffer.h"
+
+#include "threads/SingleLock.h"
+
+#include <algorithm>
+#include <string.h>
+
+CStreamBuffer::CStreamBuffer(size_t size)
+  : m_buffer(std::max<size_t>(size, 1))
+{
+  m_hReadable = CreateEvent(NULL, FALSE, FALSE, NULL);
+  m_hWritable = CreateEvent(NULL, FALSE, FALSE, NULL);
+}
+
+CStreamBuffer::~CStreamBuffer()
+{
+  if (m_hReadable)
+    CloseHandle(m_hReadable);
+  if (m_hWritable)
+    CloseHandle(m_hWritable);
+}
+
+bool CStreamBuffer::Write(const char* data, size_t size)
+{
+  while (size > 0)
+  {
+    {
+      CSingleLock lock(m_critSection);
+      if (m_bDetached || m_bClosed)
+        return false;
+
+      // copy into the free space, which may wrap around the end of the buffer
+      while (size > 0 && m_used < m_buffer.size())
+      {
+        const size_t end = (m_start + m_used) % m_buffer.size();
+        const size_t length = std::min(size, std::min(m_buffer.size() - m_used, m_buffer.size() - end));
+        memcpy(m_buffer.data() + end, data, length);
+        m_used += length;
+        data += length;
+        size -= length;
+      }
+    }
+
+    SetEvent(m_hReadable);
+    if (size > 0)
+      WaitForSingleObject(m_hWritable, INFINITE);
+  }
+
+  return true;
+}
+
+void CStreamBuffer::Close()
+{
+  {
+    CSingleLock lock(m_critSection);
+    m_bClosed = true;
+  }
+  SetEvent(m_hReadable);
+}
+
+bool CStreamBuffer::Read(char* data, size_t size)
+{
+  while (size > 0)
+  {
+    {
+      CSingleLock lock(m_critSection);
+      while (size > 0 && m_used > 0)
+      {
+        const size_t length = std::min(size, std::min(m_used, m_buffer.size() - m_start));
+        memcpy(data, m_buffer.data() + m_start, length);
+        m_start = (m_start + length) % m_buffer.size();
+        m_used -= length;
+        data += length;
+        size -= length;
+      }
+
+      if (size > 0 && m_bClosed)
+        return false;
+    }
+
+    SetEvent(m_hWritable);
+    if (size > 0)
+      WaitForSingleObject(m_hReadable, INFINITE);
+  }
+
+  return true;
+}
+
+void CStreamBuffer::Detach()
+{
+  {
+    CSingleLock lock(m_critSection);
+    m_bDetached = true;
+  }
+  SetEvent(m_hWritable);
+}
@@ -0,0 +1,68 @@
+/*
+ *  Copyright (C) 2025-2025
+ *  This file is part of XBMC - https://github.com/antonic901/xbmc4xbox-redux
+ *
+ *  SPDX-License-Identifier: GPL-2.0-or-later
+ *  See LICENSE.md for more information.
+ */
+
+#pragma once
+
+#include "threads/CriticalSection.h"
+
+#include <vector>
+#include <windows.h>
+
+/*!
+  \brief Bounded byte pipe between one producing and one consuming thread.
+
+  Write() blocks while the buffer is full, so a slow consumer holds the
+  producer back instead of letting memory grow. Either side can give up:
+  the producer by closing the pipe early, the consumer by detaching, after
+  which writes are refused without blocking.
+*/
+class CStreamBuffer
+{
+public:
+  explicit CStreamBuffer(size_t size = DEFAULT_SIZE);
+  ~CStreamBuffer();
+
+  /*!
+    \brief Appends data, waiting for the consumer to make room.
+    \return false once the consumer detached
+  */
+  bool Write(const char* data, size_t size);
+
+  /*!
+    \brief Ends the stream, the consumer still gets what was written before.
+  */
+  void Close();
+
+  /*!
+    \brief Takes exactly size bytes, waiting for the producer to write them.
+    \return false if the stream ended before that many bytes arrived
+  */
+  bool Read(char* data, size_t size);
+
+  /*!
+    \brief The consumer doesn't want any more data, pending and later writes are refused.
+  */
+  void Detach();
+
+  static const size_t DEFAULT_SIZE = 256 * 1024;
+
+private:
+  CStreamBuffer(const CStreamBuffer&) = delete;
+  CStreamBuffer& operator=(const CStreamBuffer&) = delete;
+
+  std::vector<char> m_buffer;
+  size_t m_start = 0;
+  size_t m_used = 0;
+  bool m_bClosed = false;
+  bool m_bDetached = false;
+
+  // auto-reset, set whenever the other side may be able to continue
+  HANDLE m_hReadable = NULL;
+  HANDLE m_hWritable = NULL;
+  CCriticalSection m_critSection;
+};
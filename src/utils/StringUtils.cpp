@@ -18,6 +18,8 @@
 
 #include "StringUtils.h"
 
+#include <algorithm>
+
 using namespace std;
 
 #define FORMAT_BLOCK_SIZE 512 // # of bytes for initial allocation for printf
@@ -103,6 +105,11 @@ bool StringUtils::EqualsNoCase(const char *s1, const char *s2)
   return true;
 }
 
+void StringUtils::ToLower(std::string &str)
+{
+  std::transform(str.begin(), str.end(), str.begin(), ::tolower);
+}
+
 int StringUtils::Replace(string &str, char oldChar, char newChar)
 {
   int replacedChars = 0;
@@ -136,6 +143,55 @@ int StringUtils::Replace(std::string &str, const std::string &oldStr, const std:
   return replacedChars;
 }
 
+std::string& StringUtils::Trim(std::string &str)
+{
+  TrimLeft(str);
+  return TrimRight(str);
+}
+
+// hack to check only first byte of UTF-8 character
+// without this hack "TrimX" functions failed on Win32 and OS X with UTF-8 strings
+static int isspace_c(char c)
+{
+  return (c & 0x80) == 0 && ::isspace(c);
+}
+
+std::string& StringUtils::TrimLeft(std::string &str)
+{
+  str.erase(str.begin(),
+            std::find_if(str.begin(), str.end(), [](char s) { return isspace_c(s) == 0; }));
+  return str;
+}
+
+std::string& StringUtils::TrimRight(std::string &str)
+{
+  str.erase(std::find_if(str.rbegin(), str.rend(), [](char s) { return isspace_c(s) == 0; }).base(),
+            str.end());
+  return str;
+}
+
+bool StringUtils::StartsWith(const std::string &str1, const std::string &str2)
+{
+  return str1.compare(0, str2.size(), str2) == 0;
+}
+
+bool StringUtils::StartsWith(const std::string &str1, const char *s2)
+{
+  return StartsWith(str1.c_str(), s2);
+}
+
+bool StringUtils::StartsWith(const char *s1, const char *s2)
+{
+  while (*s2 != '\0')
+  {
+    if (*s1 != *s2)
+      return false;
+    s1++;
+    s2++;
+  }
+  return true;
+}
+
 bool StringUtils::StartsWithNoCase(const std::string &str1, const std::string &str2)
 {
   return StartsWithNoCase(str1.c_str(), str2.c_str());
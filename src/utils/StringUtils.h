@@ -36,8 +36,15 @@ public:
   static bool EqualsNoCase(const std::string &str1, const std::string &str2);
   static bool EqualsNoCase(const std::string &str1, const char *s2);
   static bool EqualsNoCase(const char *s1, const char *s2);
+  static void ToLower(std::string &str);
   static int Replace(std::string &str, char oldChar, char newChar);
   static int Replace(std::string &str, const std::string &oldStr, const std::string &newStr);
+  static std::string& Trim(std::string &str);
+  static std::string& TrimLeft(std::string &str);
+  static std::string& TrimRight(std::string &str);
+  static bool StartsWith(const std::string &str1, const std::string &str2);
+  static bool StartsWith(const std::string &str1, const char *s2);
+  static bool StartsWith(const char *s1, const char *s2);
   static bool StartsWithNoCase(const std::string &str1, const std::string &str2);
   static bool StartsWithNoCase(const std::string &str1, const char *s2);
   static bool StartsWithNoCase(const char *s1, const char *s2);
@@ -0,0 +1,117 @@
+#!/usr/bin/env python3
+#
+#  Copyright (C) 2025-2025
+#  This file is part of XBMC - https://github.com/antonic901/xbmc4xbox-redux
+#
+#  SPDX-License-Identifier: GPL-2.0-or-later
+#  See LICENSE.md for more information.
+#
+# Converts a PEM CA bundle (cacert.pem) into the binary trust store that is
+# embedded into the updater. Layout, all integers little endian:
+#
+#   char     magic[4]    "XCAS"
+#   uint32   version     1
+#   uint32   count       number of certificates
+#   entry    index[count]
+#   uint8    der[]       concatenated DER certificates
+#
+# where every index entry is
+#
+#   uint32   hash        FNV-1a of the raw DER encoded subject name
+#   uint32   offset      offset of the certificate from the start of the blob
+#   uint32   length      length of the DER certificate
+#
+# The index is sorted by hash so the updater can binary search the issuer of a
+# certificate without parsing the rest of the bundle.
+
+import base64
+import struct
+import sys
+
+MAGIC = b"XCAS"
+VERSION = 1
+
+
+def fnv1a(data):
+    h = 0x811C9DC5
+    for b in data:
+        h ^= b
+        h = (h * 0x01000193) & 0xFFFFFFFF
+    return h
+
+
+def read_tlv(data, pos):
+    """Returns (tag, value start, value end) of the DER element at pos."""
+    tag = data[pos]
+    length = data[pos + 1]
+    pos += 2
+    if length & 0x80:
+        count = length & 0x7F
+        length = int.from_bytes(data[pos:pos + count], "big")
+        pos += count
+    return tag, pos, pos + length
+
+
+def subject_name(der):
+    # Certificate ::= SEQUENCE { tbsCertificate, signatureAlgorithm, signature }
+    _, pos, _ = read_tlv(der, 0)
+    # TBSCertificate ::= SEQUENCE { [0] version, serial, signature, issuer, validity, subject, ... }
+    _, pos, _ = read_tlv(der, pos)
+    if der[pos] == 0xA0:
+        _, _, pos = read_tlv(der, pos)
+    for _ in range(4):  # serialNumber, signature, issuer, validity
+        _, _, pos = read_tlv(der, pos)
+    _, _, end = read_tlv(der, pos)
+    return der[pos:end]
+
+
+def read_pem(path):
+    certs = []
+    body = None
+    with open(path, "r", encoding="ascii", errors="ignore") as f:
+        for line in f:
+            line = line.strip()
+            if line == "-----BEGIN CERTIFICATE-----":
+                body = []
+            elif line == "-----END CERTIFICATE-----":
+                if body is not None:
+                    certs.append(base64.b64decode("".join(body)))
+                body = None
+            elif body is not None:
+                body.append(line)
+    return certs
+
+
+def main():
+    if len(sys.argv) != 3:
+        print("usage: make_truststore.py <cacert.pem> <truststore.bin>", file=sys.stderr)
+        return 1
+
+    entries = []
+    seen = set()
+    for der in read_pem(sys.argv[1]):
+        if der in seen:
+            continue
+        seen.add(der)
+        entries.append((fnv1a(subject_name(der)), der))
+
+    entries.sort(key=lambda e: e[0])
+
+    offset = 12 + 12 * len(entries)
+    index = bytearray()
+    blob = bytearray()
+    for h, der in entries:
+        index += struct.pack("<III", h, offset + len(blob), len(der))
+        blob += der
+
+    with open(sys.argv[2], "wb") as f:
+        f.write(MAGIC + struct.pack("<II", VERSION, len(entries)))
+        f.write(index)
+        f.write(blob)
+
+    print("trust store: %d certificates, %d bytes" % (len(entries), 12 + len(index) + len(blob)))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())